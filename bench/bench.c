@@ -0,0 +1,578 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mock.h"
+
+/* build the window manager into this file so its static state is reachable */
+#define main wsxwm_main
+#include "../source/wsxwm.c"
+#undef main
+
+#define MAX_WINDOWS 4096
+
+typedef void (*action)(void* data, uint32_t time, uint32_t value, uint32_t state);
+
+static struct swc_window* wins[MAX_WINDOWS];
+static size_t nwins = 0;
+static struct swc_screen* scrs[8];
+static size_t nscrs = 0;
+
+static void add_screens(size_t n);
+static void add_window(void);
+static void bench_churn(size_t n);
+static void bench_focus(size_t clients, size_t iters);
+static void bench_focus_dir(size_t clients, size_t iters);
+static void bench_hotplug(size_t clients, size_t iters);
+static void bench_layout(const struct layout* l, size_t n, size_t iters);
+static void bench_monocle(size_t clients, size_t iters);
+static void bench_resize(size_t clients, size_t iters);
+static void bench_rules(size_t n, size_t iters);
+static void bench_stack(size_t clients, size_t iters);
+static void bench_workspace(size_t screens, size_t clients, size_t iters);
+static void check_warm(void);
+static void dispatch(void);
+static uint64_t now_ns(void);
+static void press(action fn, union arg a);
+static int record_session(const char* dir);
+static void report(const char* name, uint64_t ops, uint64_t ns);
+static void teardown(void);
+static size_t tiled_order(size_t* out);
+
+static void add_screens(size_t n)
+{
+	for (size_t i = 0; i < n && nscrs < LENGTH(scrs); i++) {
+		scrs[nscrs] = mock_screen_add((int32_t)(nscrs * 1920), 0, 1920, 1080);
+		nscrs++;
+	}
+	dispatch();
+}
+
+/* with an app_id up front, so it is mapped rather than held for rules[] */
+static void add_window(void)
+{
+	if (nwins < MAX_WINDOWS)
+		wins[nwins++] = mock_window_add_named("bench", NULL);
+	dispatch();
+}
+
+/* map then unmap n windows, one event each */
+static void bench_churn(size_t n)
+{
+	uint64_t t0;
+
+	add_screens(1);
+
+	mock_reset();
+	t0 = now_ns();
+	for (size_t i = 0; i < n; i++)
+		add_window();
+	while (nwins > 0) {
+		mock_window_remove(wins[--nwins]);
+		dispatch();
+	}
+	report("churn: map+unmap", n * 2, now_ns() - t0);
+
+	teardown();
+}
+
+static void bench_focus(size_t clients, size_t iters)
+{
+	uint64_t t0;
+
+	add_screens(1);
+	for (size_t i = 0; i < clients; i++)
+		add_window();
+
+	mock_reset();
+	t0 = now_ns();
+	for (size_t i = 0; i < iters; i++)
+		press(focus_next, (union arg){ .v = NULL });
+	report("focus_next", iters, now_ns() - t0);
+
+	teardown();
+}
+
+/* the spatial index is built once, every press after is a query */
+static void bench_focus_dir(size_t clients, size_t iters)
+{
+	static const uint32_t dirs[] = { DIR_RIGHT, DIR_DOWN, DIR_LEFT, DIR_UP };
+	char name[64];
+	uint64_t t0;
+
+	add_screens(1);
+	press(set_layout, (union arg){ .v = find_layout("grid") });
+	for (size_t i = 0; i < clients; i++)
+		add_window();
+
+	mock_reset();
+	t0 = now_ns();
+	for (size_t i = 0; i < iters; i++)
+		press(focus_dir, (union arg){ .u = dirs[i % LENGTH(dirs)] });
+	snprintf(name, sizeof(name), "focus_dir (%zu windows, grid)", clients);
+	report(name, iters, now_ns() - t0);
+
+	press(set_layout, (union arg){ .v = &layouts[0] });
+	teardown();
+}
+
+/* unplug the second output and plug it back, clients go away and return */
+static void bench_hotplug(size_t clients, size_t iters)
+{
+	size_t before[MAX_WINDOWS];
+	size_t after[MAX_WINDOWS];
+	char name[64];
+	uint64_t layouts;
+	uint64_t t0;
+	size_t n;
+
+	add_screens(2);
+	mock_screen_enter(scrs[1]);
+	for (size_t i = 0; i < clients; i++) {
+		press(workspace_goto, (union arg){ .u = (uint32_t)(i % 3) + 1 });
+		add_window();
+	}
+
+	mock_reset();
+	layouts = wm.count.layout_run;
+	t0 = now_ns();
+	for (size_t i = 0; i < iters; i++) {
+		mock_screen_remove(scrs[1]);
+		dispatch();
+		scrs[1] = mock_screen_add(1920, 0, 1920, 1080);
+		dispatch();
+	}
+	snprintf(name, sizeof(name), "hotplug (%zu clients, %.1f layouts)", clients,
+		(double)(wm.count.layout_run - layouts) / (double)(iters * 2));
+	report(name, iters * 2, now_ns() - t0);
+
+	/* one more round, untimed, an even number of reversals would cancel out */
+	n = tiled_order(before);
+	mock_screen_remove(scrs[1]);
+	dispatch();
+	scrs[1] = mock_screen_add(1920, 0, 1920, 1080);
+	dispatch();
+	if (tiled_order(after) != n || memcmp(before, after, n * sizeof(*before)) != 0) {
+		printf("hotplug: clients came back in another tiled order\n");
+		exit(EXIT_FAILURE);
+	}
+
+	teardown();
+}
+
+/* the layout function alone, no wm state involved */
+static void bench_layout(const struct layout* l, size_t n, size_t iters)
+{
+	struct swc_rectangle out[256];
+	struct layout_params p = {
+		.area = { 0, 0, 3440, 1440 },
+		.gaps = cfg.gaps,
+		.border_width = cfg.border_width,
+		.master_width = 2000,
+	};
+	char name[64];
+	uint64_t t0;
+	volatile uint32_t sink = 0;
+
+	if (n > LENGTH(out))
+		n = LENGTH(out);
+
+	mock_reset();
+	t0 = now_ns();
+	for (size_t i = 0; i < iters; i++) {
+		l->fn(&p, n, out);
+		sink += out[n - 1].width;
+	}
+	snprintf(name, sizeof(name), "layout %s (%zu windows)", l->name, n);
+	report(name, iters, now_ns() - t0);
+	(void)sink;
+}
+
+/* focus_next under monocle swaps which window is shown, and checks it did */
+static void bench_monocle(size_t clients, size_t iters)
+{
+	char name[64];
+	struct client* c;
+	uint64_t t0;
+
+	add_screens(1);
+	press(set_layout, (union arg){ .v = find_layout("monocle") });
+	for (size_t i = 0; i < clients; i++)
+		add_window();
+
+	mock_reset();
+	t0 = now_ns();
+	for (size_t i = 0; i < iters; i++)
+		press(focus_next, (union arg){ .v = NULL });
+	snprintf(name, sizeof(name), "focus_next (%zu windows, monocle)", clients);
+	report(name, iters, now_ns() - t0);
+
+	/* one more round, untimed: the focused window is the only one up */
+	for (size_t i = 0; i < clients; i++) {
+		press(focus_next, (union arg){ .v = NULL });
+		c = client_at(wm.sel_client);
+		for (size_t j = 0; j < nwins; j++) {
+			bool up = ((struct mock_window*)wins[j])->visible;
+
+			/* stderr is /dev/null without -v */
+			if (up != (c && wins[j] == c->win)) {
+				printf("monocle: window %zu is %s\n", j, up ? "shown under the focused one" : "focused but hidden");
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	press(set_layout, (union arg){ .v = &layouts[0] });
+	teardown();
+}
+
+static void bench_resize(size_t clients, size_t iters)
+{
+	uint64_t t0;
+
+	add_screens(1);
+	for (size_t i = 0; i < clients; i++)
+		add_window();
+
+	mock_reset();
+	t0 = now_ns();
+	for (size_t i = 0; i < iters; i++)
+		press(master_resize, (union arg){ .i = (i & 1) ? -50 : 50 });
+	report("master_resize", iters, now_ns() - t0);
+
+	teardown();
+}
+
+/* lookups in an index of n app_id rules, half of them misses */
+static void bench_rules(size_t n, size_t iters)
+{
+	char name[64];
+	char (*keys)[16];
+	struct rule* rs;
+	struct rule_index ri;
+	size_t hits = 0;
+	uint64_t t0;
+
+	keys = calloc(n * 2, sizeof(*keys));
+	rs = calloc(n, sizeof(*rs));
+	if (!keys || !rs)
+		die(EXIT_FAILURE, "rule bench alloc failed");
+
+	for (size_t i = 0; i < n * 2; i++)
+		snprintf(keys[i], sizeof(keys[i]), "org.app%zu", i);
+	for (size_t i = 0; i < n; i++)
+		rs[i] = (struct rule){ .app_id = keys[i], .screen = -1, .floating = -1 };
+	rules_init(&ri, rs, n);
+
+	mock_reset();
+	t0 = now_ns();
+	for (size_t i = 0; i < iters; i++)
+		hits += rules_match(&ri, keys[(i * 7) % (n * 2)], "title") != NULL;
+	snprintf(name, sizeof(name), "rules_match (%zu rules, %zu%% hit)", n, hits * 100 / iters);
+	report(name, iters, now_ns() - t0);
+
+	rules_finish(&ri);
+	free(rs);
+	free(keys);
+}
+
+/* raise floats on one workspace, then flip away and back */
+static void bench_stack(size_t clients, size_t iters)
+{
+	char name[64];
+	uint64_t t0;
+
+	add_screens(1);
+	wm.global_floating = true;
+	for (size_t ws = 2; ws >= 1; ws--) {
+		press(workspace_goto, (union arg){ .u = (uint32_t)ws });
+		for (size_t i = 0; i < clients; i++)
+			add_window();
+	}
+	wm.global_floating = false;
+
+	mock_reset();
+	t0 = now_ns();
+	for (size_t i = 0; i < iters; i++)
+		mock_window_enter(wins[clients + (i * 7) % clients]);
+	snprintf(name, sizeof(name), "raise (%zu floats)", clients);
+	report(name, iters, now_ns() - t0);
+
+	mock_reset();
+	t0 = now_ns();
+	for (size_t i = 0; i < iters; i++)
+		press(workspace_goto, (union arg){ .u = (uint32_t)(i % 2) + 1 });
+	snprintf(name, sizeof(name), "restack on goto (%zu floats)", clients);
+	report(name, iters, now_ns() - t0);
+
+	press(workspace_goto, (union arg){ .u = 1 });
+	teardown();
+}
+
+/* clients are spread over every screen and workspace */
+static void bench_workspace(size_t screens, size_t clients, size_t iters)
+{
+	char name[64];
+	uint64_t t0;
+	size_t i = 0;
+
+	add_screens(screens);
+	while (i < clients) {
+		for (size_t j = 0; j < nscrs && i < clients; j++, i++) {
+			mock_screen_enter(scrs[j]);
+			press(workspace_goto, (union arg){ .u = (uint32_t)(i % WS_COUNT) + 1 });
+			add_window();
+		}
+	}
+
+	/* switching on one screen must leave the others alone */
+	mock_screen_enter(scrs[0]);
+	mock_reset();
+	t0 = now_ns();
+	for (i = 0; i < iters; i++)
+		press(workspace_goto, (union arg){ .u = (uint32_t)(i % WS_COUNT) + 1 });
+	snprintf(name, sizeof(name), "workspace_goto (%zu screens)", screens);
+	report(name, iters, now_ns() - t0);
+
+	for (size_t j = 0; j < nscrs; j++) {
+		mock_screen_enter(scrs[j]);
+		press(workspace_goto, (union arg){ .u = 1 });
+	}
+	teardown();
+}
+
+/* windows with a pool's app_id are parked only while one of its launches waits */
+static void check_warm(void)
+{
+	static const char* argv[] = { "sleep", "1", NULL };
+	static const struct warm_pool pool = { "bench-warm", argv, 1, 0, 0, 50 };
+	struct swc_window* w[3];
+	const char* what = NULL;
+	uint64_t until;
+
+	warm_init(&pool, 1);
+	add_screens(1);
+	/* the first launch is made from a timer */
+	for (int i = 0; i < 10 && !warm_pending(); i++)
+		wl_event_loop_dispatch(wm.ev_loop, 5);
+
+	w[0] = mock_window_add_named("bench-warm", NULL);
+	dispatch();
+	w[1] = mock_window_add_named("bench-warm", NULL);
+	dispatch();
+	if (((struct mock_window*)w[0])->visible)
+		what = "the launched window was shown";
+	else if (!((struct mock_window*)w[1])->visible)
+		what = "a second window was parked for the same launch";
+
+	/* taken, the pool launches again, and gives up on that after wait_ms */
+	if (!what && warm_take((char* const*)argv) != ((struct mock_window*)w[0])->data)
+		what = "the parked window was not handed out";
+	for (int i = 0; i < 10 && !warm_pending(); i++)
+		wl_event_loop_dispatch(wm.ev_loop, 5);
+	if (!what && !warm_pending())
+		what = "nothing was launched after a take";
+	until = stats_now() + 2 * (uint64_t)pool.wait_ms * 1000000;
+	while (stats_now() < until)
+		wl_event_loop_dispatch(wm.ev_loop, 5);
+	if (!what && warm_pending())
+		what = "a launch was still waited for past wait_ms";
+
+	w[2] = mock_window_add_named("bench-warm", NULL);
+	dispatch();
+	if (!what && !((struct mock_window*)w[2])->visible)
+		what = "a window was parked after its launch was given up on";
+
+	for (size_t i = 0; i < LENGTH(w); i++)
+		mock_window_remove(w[i]);
+	dispatch();
+	warm_finish();
+	teardown();
+
+	if (what) {
+		printf("warm: %s\n", what);
+		exit(EXIT_FAILURE);
+	}
+}
+
+static void dispatch(void)
+{
+	wl_event_loop_dispatch_idle(wm.ev_loop);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void press(action fn, union arg a)
+{
+	fn(&a, 0, 0, WL_KEYBOARD_KEY_STATE_PRESSED);
+	dispatch();
+}
+
+/*
+ * a scripted session, with its window calls written to dir/session.log
+ * and its trace to dir/session.trace. replaying the trace has to give
+ * the same calls, "make check" compares the two.
+ */
+static int record_session(const char* dir)
+{
+	static const char* ids[] = { "bench", NULL, "mpv" };
+	struct swc_window* w[10];
+	char path[256];
+	FILE* log;
+
+	snprintf(path, sizeof(path), "%s/session.log", dir);
+	log = fopen(path, "w");
+	if (!log)
+		return -1;
+	mock_log = log;
+
+	add_screens(2);
+	for (size_t i = 0; i < LENGTH(w); i++) {
+		if (i == LENGTH(w) / 2)
+			mock_screen_enter(scrs[1]);
+		w[i] = mock_window_add_named(ids[i % LENGTH(ids)], NULL);
+		wl_event_loop_dispatch(wm.ev_loop, 0);
+	}
+	mock_window_enter(w[2]);
+
+	/* through run_bind() and run_action(), like input, so they are traced */
+	for (size_t i = 0; i < LENGTH(binds); i++) {
+		if (binds[i].fn == focus_next || binds[i].fn == workspace_goto || binds[i].fn == cycle_layout) {
+			run_bind(&binds[i], 0, 0, WL_KEYBOARD_KEY_STATE_PRESSED);
+			wl_event_loop_dispatch(wm.ev_loop, 0);
+		}
+	}
+	run_action(find_action("workspace_moveto"), &(union arg){ .u = 2 }, 0);
+	wl_event_loop_dispatch(wm.ev_loop, 0);
+
+	mock_window_remove(w[3]);
+	wl_event_loop_dispatch(wm.ev_loop, 0);
+	mock_screen_remove(scrs[1]);
+	wl_event_loop_dispatch(wm.ev_loop, 0);
+	scrs[1] = mock_screen_add(1920, 0, 1920, 1080);
+	wl_event_loop_dispatch(wm.ev_loop, 0);
+	mock_screen_set_usable(scrs[0], &(struct swc_rectangle){ 0, 30, 1920, 1050 }, true);
+	wl_event_loop_dispatch(wm.ev_loop, 0);
+
+	mock_log = NULL;
+	fclose(log);
+
+	snprintf(path, sizeof(path), "%s/session.trace", dir);
+	return dump_trace(path);
+}
+
+static void report(const char* name, uint64_t ops, uint64_t ns)
+{
+	double n = ops ? (double)ops : 1.0;
+
+	printf("%-32s %8llu ops %10.1f ns/op %7.2f swc/op",
+		name, (unsigned long long)ops, (double)ns / n, (double)mock_calls_total() / n);
+
+	for (int i = 0; i < CALL_COUNT; i++) {
+		if (mock_calls[i])
+			printf("  %s=%.2f", mock_call_names[i], (double)mock_calls[i] / n);
+	}
+	putchar('\n');
+}
+
+static void teardown(void)
+{
+	while (nwins > 0)
+		mock_window_remove(wins[--nwins]);
+	dispatch();
+
+	while (nscrs > 0)
+		mock_screen_remove(scrs[--nscrs]);
+	dispatch();
+
+	master_width = 0;
+}
+
+/* window indices in tiled order, over every workspace of every screen */
+static size_t tiled_order(size_t* out)
+{
+	struct screen* s;
+	struct client* c;
+	size_t n = 0;
+
+	wl_list_for_each(s, &wm.screens, link) {
+		for (size_t i = 0; i < WS_COUNT; i++) {
+			wl_list_for_each(c, &s->ws[i].tiled, tiled_link) {
+				for (size_t j = 0; j < nwins; j++) {
+					if (wins[j] == c->win)
+						out[n++] = j;
+				}
+			}
+		}
+	}
+
+	return n;
+}
+
+int main(int argc, char** argv)
+{
+	char dir[] = "/tmp/wsxwm-bench-XXXXXX";
+	bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+	const char* record = argc > 2 && strcmp(argv[1], "-r") == 0 ? argv[2] : NULL;
+	int status = EXIT_SUCCESS;
+
+	/* wl_display_add_socket_auto needs a runtime dir */
+	if (!getenv("XDG_RUNTIME_DIR")) {
+		if (!mkdtemp(dir))
+			die(EXIT_FAILURE, "mkdtemp failed");
+		setenv("XDG_RUNTIME_DIR", dir, 1);
+	}
+
+	if (!verbose && !freopen("/dev/null", "w", stderr))
+		return EXIT_FAILURE;
+
+	setup();
+	/* the warm pool would start real processes */
+	warm_finish();
+
+	if (record) {
+		if (record_session(record) < 0) {
+			printf("cannot record the session to %s\n", record);
+			status = EXIT_FAILURE;
+		}
+	}
+	else {
+		check_warm();
+		bench_churn(1000);
+		bench_focus(32, 100000);
+		bench_focus_dir(32, 100000);
+		bench_hotplug(30, 1000);
+		bench_resize(16, 10000);
+		bench_rules(10, 100000);
+		bench_rules(1000, 100000);
+		bench_stack(16, 10000);
+		for (size_t i = 0; i < LENGTH(layouts); i++)
+			bench_layout(&layouts[i], 32, 100000);
+		bench_monocle(16, 10000);
+		bench_workspace(1, 300, 10000);
+		bench_workspace(2, 300, 10000);
+		bench_workspace(3, 300, 10000);
+	}
+
+	if (verbose)
+		dump_stats(stdout);
+
+	ipc_finish();
+	swc_finalize();
+	cleanup();
+	log_finish();
+	wl_display_destroy(wm.dpy);
+
+	if (dir[sizeof(dir) - 2] != 'X')
+		rmdir(dir);
+
+	return status;
+}
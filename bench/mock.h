@@ -0,0 +1,56 @@
+#ifndef MOCK_H
+#define MOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <swc.h>
+
+enum {
+	CALL_SHOW,
+	CALL_HIDE,
+	CALL_FOCUS,
+	CALL_SET_GEOMETRY,
+	CALL_SET_BORDER,
+	CALL_SET_STACKED,
+	CALL_SET_TILED,
+	CALL_SET_FULLSCREEN,
+	CALL_OTHER,
+	CALL_COUNT,
+};
+
+struct mock_window {
+	struct swc_window base;
+	const struct swc_window_handler* handler;
+	void*          data;
+	uint32_t       id;
+	bool           visible;
+	struct swc_rectangle geom;
+};
+
+struct mock_screen {
+	struct swc_screen base;
+	const struct swc_screen_handler* handler;
+	void*          data;
+};
+
+/* when set, every window call is printed there as it happens */
+extern FILE* mock_log;
+extern uint64_t mock_calls[CALL_COUNT];
+extern const char* mock_call_names[CALL_COUNT];
+
+uint64_t mock_calls_total(void);
+void mock_reset(void);
+struct swc_screen* mock_screen_add(int32_t x, int32_t y, uint32_t w, uint32_t h);
+void mock_screen_enter(struct swc_screen* scr);
+void mock_screen_remove(struct swc_screen* scr);
+void mock_screen_set_geometry(struct swc_screen* scr, const struct swc_rectangle* geom);
+void mock_screen_set_usable(struct swc_screen* scr, const struct swc_rectangle* geom, bool notify);
+void mock_window_enter(struct swc_window* win);
+struct swc_window* mock_window_add(void);
+struct swc_window* mock_window_add_named(const char* app_id, const char* title);
+void mock_window_remove(struct swc_window* win);
+void mock_window_set_app_id(struct swc_window* win, const char* app_id);
+
+#endif /* MOCK_H */
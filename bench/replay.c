@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mock.h"
+
+/* build the window manager into this file so its static state is reachable */
+#define main wsxwm_main
+#include "../source/wsxwm.c"
+#undef main
+
+/*
+ * feeds a trace written by the "trace" ipc query back through the wm,
+ * against the mock swc, and prints every window call it makes. the same
+ * trace always gives the same output, so two runs can be diffed; -q
+ * drops the calls and keeps only the timing, -c keeps only the calls. binds, actions and rules
+ * are looked up by index, the trace must come from a build of the same
+ * config.h. spawns are never run, the windows they led to are in the
+ * trace anyway, and the warm pool is off so every window is mapped as it
+ * appears. -p paces the replay at the recorded speed, without it
+ * timers (focus_delay_ms) do not fire and held windows are let go once
+ * the trace is past their deadline.
+ */
+
+struct obj {
+	uint64_t       id;
+	void*          mock;
+	uint64_t       skew;        /* trace time less stats_now() when it was made */
+};
+
+static void obj_drop(uint64_t id);
+static void* obj_get(uint64_t id);
+static struct obj* obj_put(uint64_t id, void* mock);
+static void release_held(uint64_t t);
+static bool replay(const struct trace_rec* r);
+static void usage(void);
+
+static struct obj* objs = NULL;
+static size_t nobjs = 0;
+static size_t objs_cap = 0;
+static struct hist replay_hist[TRACE_TYPES];
+
+static void obj_drop(uint64_t id)
+{
+	for (size_t i = 0; i < nobjs; i++) {
+		if (objs[i].id == id) {
+			objs[i] = objs[--nobjs];
+			return;
+		}
+	}
+}
+
+static void* obj_get(uint64_t id)
+{
+	for (size_t i = 0; i < nobjs; i++) {
+		if (objs[i].id == id)
+			return objs[i].mock;
+	}
+
+	return NULL;
+}
+
+static struct obj* obj_put(uint64_t id, void* mock)
+{
+	if (nobjs == objs_cap) {
+		objs_cap = objs_cap ? objs_cap * 2 : 64;
+		objs = realloc(objs, objs_cap * sizeof(*objs));
+		if (!objs)
+			die(EXIT_FAILURE, "obj table realloc failed");
+	}
+
+	objs[nobjs] = (struct obj){ id, mock, 0 };
+	return &objs[nobjs++];
+}
+
+/* in trace order what the hold timer would have shown by trace time t */
+static void release_held(uint64_t t)
+{
+	struct client* c;
+	const struct obj* o;
+	bool due = false;
+
+	wl_list_for_each(c, &wm.held, tiled_link) {
+		o = NULL;
+		for (size_t i = 0; i < nobjs && !o; i++) {
+			if (objs[i].mock == c->win)
+				o = &objs[i];
+		}
+		if (!o || c->held_until + o->skew > t)
+			break;
+
+		c->held_until = 0;
+		due = true;
+	}
+
+	if (due)
+		on_hold_timer(NULL);
+}
+
+/* false if the record refers to something created before the trace began */
+static bool replay(const struct trace_rec* r)
+{
+	const struct action* a;
+	const struct rule* rule;
+	union arg arg = { .v = NULL };
+	const char* app_id;
+	uint64_t now;
+	void* o = NULL;
+
+	if (r->type != TRACE_NEW_SCREEN && r->type != TRACE_NEW_WINDOW
+		&& r->type != TRACE_BIND && r->type != TRACE_ACTION) {
+		o = obj_get(r->obj);
+		if (!o)
+			return false;
+	}
+
+	switch (r->type) {
+	case TRACE_NEW_SCREEN:
+		obj_put(r->obj, mock_screen_add(r->u.geom.x, r->u.geom.y, r->u.geom.width, r->u.geom.height));
+		break;
+	case TRACE_SCREEN_DESTROY:
+		obj_drop(r->obj);
+		mock_screen_remove(o);
+		break;
+	case TRACE_SCREEN_GEOMETRY:
+		mock_screen_set_geometry(o, &r->u.geom);
+		break;
+	case TRACE_SCREEN_USABLE:
+		mock_screen_set_usable(o, &r->u.geom, r->index != TRACE_USABLE_INITIAL);
+		break;
+	case TRACE_SCREEN_ENTERED:
+		mock_screen_enter(o);
+		break;
+	case TRACE_NEW_WINDOW:
+		/*
+		 * only the rule it matched is known, its keys stand in for the
+		 * names, and an app_id no rule looked at for one that none match
+		 */
+		app_id = r->flags & TRACE_HAS_APP_ID ? "wsxwm-replay" : NULL;
+		rule = r->index && r->index <= LENGTH(rules) ? &rules[r->index - 1] : NULL;
+		now = stats_now();
+		if (rule)
+			o = mock_window_add_named(rule->app_id ? rule->app_id : app_id, rule->title);
+		else
+			o = mock_window_add_named(app_id, NULL);
+		obj_put(r->obj, o)->skew = r->t - now;
+		break;
+	case TRACE_WIN_DESTROY:
+		obj_drop(r->obj);
+		mock_window_remove(o);
+		break;
+	case TRACE_WIN_ENTERED:
+		mock_window_enter(o);
+		break;
+	case TRACE_WIN_APP_ID:
+		if (r->index && r->index <= LENGTH(rules)) {
+			if (rules[r->index - 1].title)
+				((struct swc_window*)o)->title = (char*)rules[r->index - 1].title;
+			mock_window_set_app_id(o, rules[r->index - 1].app_id ? rules[r->index - 1].app_id : "");
+		}
+		else {
+			mock_window_set_app_id(o, "");
+		}
+		break;
+	case TRACE_BIND:
+		if (r->index >= LENGTH(binds))
+			return false;
+		if (binds[r->index].fn != spawn)
+			run_bind(&binds[r->index], r->u.input.time, r->u.input.value, r->u.input.state);
+		break;
+	case TRACE_ACTION:
+		if (r->index >= LENGTH(actions))
+			return false;
+
+		a = &actions[r->index];
+		if (a->arg == ARG_CMD || a->arg == ARG_POINTER)
+			return true;
+		if (a->arg == ARG_LAYOUT) {
+			if (r->u.input.arg < 0 || (size_t)r->u.input.arg >= LENGTH(layouts))
+				return false;
+			arg.v = &layouts[r->u.input.arg];
+		}
+		else {
+			arg.i = r->u.input.arg;
+		}
+		/* through run_action(), so the layout sees it as input like live */
+		run_action(a, &arg, r->u.input.time);
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: wsxwm-replay [-c] [-p] [-q] [-v] trace\n");
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv)
+{
+	char dir[] = "/tmp/wsxwm-replay-XXXXXX";
+	struct trace_header h;
+	struct trace_rec r;
+	bool calls = false;
+	bool pace = false;
+	bool quiet = false;
+	bool verbose = false;
+	uint64_t skipped = 0;
+	uint64_t prev_t = 0;
+	uint64_t total = 0;
+	uint64_t t0;
+	FILE* in;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "cpqv")) != -1) {
+		switch (opt) {
+		case 'c': calls = true;   break;
+		case 'p': pace = true;    break;
+		case 'q': quiet = true;   break;
+		case 'v': verbose = true; break;
+		default:  usage();
+		}
+	}
+	if (optind != argc - 1)
+		usage();
+
+	in = fopen(argv[optind], "rb");
+	if (!in)
+		die(EXIT_FAILURE, "cannot open %s", argv[optind]);
+
+	if (fread(&h, sizeof(h), 1, in) != 1 || memcmp(h.magic, TRACE_MAGIC, sizeof(h.magic)) != 0)
+		die(EXIT_FAILURE, "%s is not a trace", argv[optind]);
+	if (h.version != TRACE_VERSION || h.rec_size != sizeof(r))
+		die(EXIT_FAILURE, "trace version %u, record size %u not supported", h.version, h.rec_size);
+	if (h.nbinds != LENGTH(binds) || h.nactions != LENGTH(actions) || h.nrules != LENGTH(rules))
+		die(EXIT_FAILURE, "trace is from a build with %u binds, %u actions and %u rules, "
+			"this one has %zu, %zu and %zu", h.nbinds, h.nactions, h.nrules,
+			LENGTH(binds), LENGTH(actions), LENGTH(rules));
+
+	/* wl_display_add_socket_auto needs a runtime dir */
+	if (!getenv("XDG_RUNTIME_DIR")) {
+		if (!mkdtemp(dir))
+			die(EXIT_FAILURE, "mkdtemp failed");
+		setenv("XDG_RUNTIME_DIR", dir, 1);
+	}
+
+	if (!verbose && !freopen("/dev/null", "w", stderr))
+		return EXIT_FAILURE;
+
+	setup();
+	/* the warm pool would start real processes */
+	warm_finish();
+	for (size_t i = 0; i < TRACE_TYPES; i++)
+		replay_hist[i].name = trace_names[i];
+
+	if (h.dropped && !calls)
+		printf("# %llu records before this trace were lost, objects they created are skipped\n",
+			(unsigned long long)h.dropped);
+
+	mock_log = quiet ? NULL : stdout;
+	while (fread(&r, sizeof(r), 1, in) == 1) {
+		if (r.type >= TRACE_TYPES) {
+			skipped++;
+			continue;
+		}
+
+		/* waiting on the loop rather than sleeping lets timers fire on time */
+		if (pace && prev_t && r.t > prev_t)
+			wl_event_loop_dispatch(wm.ev_loop, (int)((r.t - prev_t) / 1000000));
+		prev_t = r.t;
+
+		if (!quiet && !calls)
+			printf("%.3f %s\n", (double)r.t / 1e6, trace_names[r.type]);
+
+		if (!pace)
+			release_held(r.t);
+
+		/* the idle layout pass is part of the cost of the event */
+		t0 = stats_now();
+		if (!replay(&r))
+			skipped++;
+		wl_event_loop_dispatch(wm.ev_loop, 0);
+		hist_record(&replay_hist[r.type], stats_now() - t0);
+		total++;
+	}
+	mock_log = NULL;
+	fclose(in);
+
+	if (!calls) {
+		printf("# %llu records, %llu skipped\n", (unsigned long long)total, (unsigned long long)skipped);
+		for (size_t i = 0; i < TRACE_TYPES; i++)
+			hist_dump(&replay_hist[i], stdout);
+	}
+	if (verbose)
+		dump_stats(stdout);
+
+	ipc_finish();
+	swc_finalize();
+	cleanup();
+	log_finish();
+	wl_display_destroy(wm.dpy);
+	free(objs);
+
+	if (dir[sizeof(dir) - 2] != 'X')
+		rmdir(dir);
+
+	return EXIT_SUCCESS;
+}
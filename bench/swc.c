@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <swc.h>
+
+#include "mock.h"
+
+#define MOCK_WINDOW(w) ((struct mock_window*)(w))
+#define MOCK_SCREEN(s) ((struct mock_screen*)(s))
+
+FILE* mock_log = NULL;
+uint64_t mock_calls[CALL_COUNT];
+const char* mock_call_names[CALL_COUNT] = {
+	[CALL_SHOW]           = "show",
+	[CALL_HIDE]           = "hide",
+	[CALL_FOCUS]          = "focus",
+	[CALL_SET_GEOMETRY]   = "set_geometry",
+	[CALL_SET_BORDER]     = "set_border",
+	[CALL_SET_STACKED]    = "set_stacked",
+	[CALL_SET_TILED]      = "set_tiled",
+	[CALL_SET_FULLSCREEN] = "set_fullscreen",
+	[CALL_OTHER]          = "other",
+};
+
+static void note(int call, struct swc_window* window);
+
+static const struct swc_manager* manager;
+static uint32_t next_id = 1;
+
+/* count a call and, for replays, print it with the window it went to */
+static void note(int call, struct swc_window* window)
+{
+	const struct swc_rectangle* g;
+
+	mock_calls[call]++;
+	if (!mock_log)
+		return;
+
+	fprintf(mock_log, "\t%s w%u", mock_call_names[call], window ? MOCK_WINDOW(window)->id : 0);
+	if (call == CALL_SET_GEOMETRY || call == CALL_SET_FULLSCREEN) {
+		g = &MOCK_WINDOW(window)->geom;
+		fprintf(mock_log, " %d,%d,%ux%u", g->x, g->y, g->width, g->height);
+	}
+	fputc('\n', mock_log);
+}
+
+uint64_t mock_calls_total(void)
+{
+	uint64_t n = 0;
+
+	for (int i = 0; i < CALL_COUNT; i++)
+		n += mock_calls[i];
+
+	return n;
+}
+
+void mock_reset(void)
+{
+	for (int i = 0; i < CALL_COUNT; i++)
+		mock_calls[i] = 0;
+}
+
+struct swc_screen* mock_screen_add(int32_t x, int32_t y, uint32_t w, uint32_t h)
+{
+	struct mock_screen* s;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		abort();
+
+	s->base.geometry = (struct swc_rectangle){ x, y, w, h };
+	s->base.usable_geometry = s->base.geometry;
+
+	if (manager && manager->new_screen)
+		manager->new_screen(&s->base);
+
+	return &s->base;
+}
+
+void mock_screen_remove(struct swc_screen* scr)
+{
+	struct mock_screen* s = MOCK_SCREEN(scr);
+
+	if (s->handler && s->handler->destroy)
+		s->handler->destroy(s->data);
+
+	free(s);
+}
+
+/* the outer geometry, swc reports it before the usable one */
+void mock_screen_set_geometry(struct swc_screen* scr, const struct swc_rectangle* geom)
+{
+	struct mock_screen* s = MOCK_SCREEN(scr);
+
+	s->base.geometry = *geom;
+	if (s->handler && s->handler->geometry_changed)
+		s->handler->geometry_changed(s->data);
+}
+
+void mock_screen_set_usable(struct swc_screen* scr, const struct swc_rectangle* geom, bool notify)
+{
+	struct mock_screen* s = MOCK_SCREEN(scr);
+
+	s->base.usable_geometry = *geom;
+	if (notify && s->handler && s->handler->usable_geometry_changed)
+		s->handler->usable_geometry_changed(s->data);
+}
+
+void mock_screen_enter(struct swc_screen* scr)
+{
+	struct mock_screen* s = MOCK_SCREEN(scr);
+
+	if (s->handler && s->handler->entered)
+		s->handler->entered(s->data);
+}
+
+void mock_window_enter(struct swc_window* win)
+{
+	struct mock_window* w = MOCK_WINDOW(win);
+
+	if (w->handler && w->handler->entered)
+		w->handler->entered(w->data);
+}
+
+struct swc_window* mock_window_add(void)
+{
+	return mock_window_add_named(NULL, NULL);
+}
+
+/* app_id and title as the client set them before the window was announced */
+struct swc_window* mock_window_add_named(const char* app_id, const char* title)
+{
+	struct mock_window* w;
+
+	w = calloc(1, sizeof(*w));
+	if (!w)
+		abort();
+	w->id = next_id++;
+	w->base.app_id = (char*)app_id;
+	w->base.title = (char*)title;
+
+	if (manager && manager->new_window)
+		manager->new_window(&w->base);
+
+	return &w->base;
+}
+
+void mock_window_set_app_id(struct swc_window* win, const char* app_id)
+{
+	struct mock_window* w = MOCK_WINDOW(win);
+
+	w->base.app_id = (char*)app_id;
+	if (w->handler && w->handler->app_id_changed)
+		w->handler->app_id_changed(w->data);
+}
+
+void mock_window_remove(struct swc_window* win)
+{
+	struct mock_window* w = MOCK_WINDOW(win);
+
+	if (w->handler && w->handler->destroy)
+		w->handler->destroy(w->data);
+
+	free(w);
+}
+
+/* swc api */
+
+int swc_add_binding(enum swc_binding_type type, uint32_t modifiers, uint32_t value, swc_binding_handler handler, void* data)
+{
+	(void)type;
+	(void)modifiers;
+	(void)value;
+	(void)handler;
+	(void)data;
+
+	return 0;
+}
+
+void swc_finalize(void)
+{
+	manager = NULL;
+}
+
+bool swc_initialize(struct wl_display* display, struct wl_event_loop* event_loop, const struct swc_manager* m)
+{
+	(void)display;
+	(void)event_loop;
+
+	manager = m;
+	return true;
+}
+
+void swc_screen_set_handler(struct swc_screen* screen, const struct swc_screen_handler* handler, void* data)
+{
+	MOCK_SCREEN(screen)->handler = handler;
+	MOCK_SCREEN(screen)->data = data;
+}
+
+void swc_window_begin_move(struct swc_window* window)
+{
+	(void)window;
+	mock_calls[CALL_OTHER]++;
+}
+
+void swc_window_begin_resize(struct swc_window* window, uint32_t edges)
+{
+	(void)window;
+	(void)edges;
+	mock_calls[CALL_OTHER]++;
+}
+
+void swc_window_close(struct swc_window* window)
+{
+	(void)window;
+	mock_calls[CALL_OTHER]++;
+}
+
+void swc_window_end_move(struct swc_window* window)
+{
+	(void)window;
+	mock_calls[CALL_OTHER]++;
+}
+
+void swc_window_end_resize(struct swc_window* window)
+{
+	(void)window;
+	mock_calls[CALL_OTHER]++;
+}
+
+void swc_window_focus(struct swc_window* window)
+{
+	(void)window;
+	note(CALL_FOCUS, window);
+}
+
+void swc_window_hide(struct swc_window* window)
+{
+	MOCK_WINDOW(window)->visible = false;
+	note(CALL_HIDE, window);
+}
+
+void swc_window_set_border(struct swc_window* window, uint32_t inner_color, uint32_t inner_width, uint32_t outer_color, uint32_t outer_width)
+{
+	(void)window;
+	(void)inner_color;
+	(void)inner_width;
+	(void)outer_color;
+	(void)outer_width;
+	note(CALL_SET_BORDER, window);
+}
+
+void swc_window_set_fullscreen(struct swc_window* window, struct swc_screen* screen)
+{
+	MOCK_WINDOW(window)->geom = screen->geometry;
+	note(CALL_SET_FULLSCREEN, window);
+}
+
+void swc_window_set_geometry(struct swc_window* window, const struct swc_rectangle* geometry)
+{
+	MOCK_WINDOW(window)->geom = *geometry;
+	note(CALL_SET_GEOMETRY, window);
+}
+
+void swc_window_set_handler(struct swc_window* window, const struct swc_window_handler* handler, void* data)
+{
+	MOCK_WINDOW(window)->handler = handler;
+	MOCK_WINDOW(window)->data = data;
+}
+
+void swc_window_set_position(struct swc_window* window, int32_t x, int32_t y)
+{
+	MOCK_WINDOW(window)->geom.x = x;
+	MOCK_WINDOW(window)->geom.y = y;
+	note(CALL_SET_GEOMETRY, window);
+}
+
+void swc_window_set_size(struct swc_window* window, uint32_t width, uint32_t height)
+{
+	MOCK_WINDOW(window)->geom.width = width;
+	MOCK_WINDOW(window)->geom.height = height;
+	note(CALL_SET_GEOMETRY, window);
+}
+
+void swc_window_set_stacked(struct swc_window* window)
+{
+	(void)window;
+	note(CALL_SET_STACKED, window);
+}
+
+void swc_window_set_tiled(struct swc_window* window)
+{
+	(void)window;
+	note(CALL_SET_TILED, window);
+}
+
+void swc_window_show(struct swc_window* window)
+{
+	MOCK_WINDOW(window)->visible = true;
+	note(CALL_SHOW, window);
+}
@@ -2,19 +2,46 @@ CC      ?= cc
 # CFLAGS   = -std=c99 -Wall -Wextra -O0 -g # debug
 CFLAGS   = -std=c99 -Wall -Wextra -O2
 CPPFLAGS = -D_POSIX_C_SOURCE=200809L -Isource/include
+# CPPFLAGS += -DLOG_LEVEL=3 # log new windows and screens
 
 OUT = wsxwm
-SRC = source/wsxwm.c source/util.c
+SRC = source/wsxwm.c source/util.c source/stats.c source/ipc.c source/launch.c source/log.c source/layout.c source/pool.c source/rules.c source/spatial.c source/trace.c source/status.c source/warm.c
 
 PKGS = swc wayland-server xkbcommon libinput pixman-1 libdrm wld libudev xcb xcb-composite xcb-ewmh xcb-icccm
 
+# bench links against the mock swc in bench/, no gpu or seat needed
+BENCH_OUT  = wsxwm-bench
+BENCH_SRC  = bench/bench.c bench/swc.c source/util.c source/stats.c source/ipc.c source/launch.c source/log.c source/layout.c source/pool.c source/rules.c source/spatial.c source/trace.c source/status.c source/warm.c
+BENCH_PKGS = wayland-server xkbcommon
+
+# replays a trace from the "trace" ipc query against the same mock
+REPLAY_OUT = wsxwm-replay
+REPLAY_SRC = bench/replay.c bench/swc.c source/util.c source/stats.c source/ipc.c source/launch.c source/log.c source/layout.c source/pool.c source/rules.c source/spatial.c source/trace.c source/status.c source/warm.c
+
 all: $(OUT)
 
 $(OUT): $(SRC)
 	$(CC) $(CFLAGS) $(CPPFLAGS) -o $(OUT) $(SRC) $(LDLIBS)
 
+$(BENCH_OUT): $(BENCH_SRC) $(SRC) bench/mock.h bench/swc.h
+	$(CC) -Ibench $(CFLAGS) $(BENCH_CFLAGS) $(CPPFLAGS) -o $(BENCH_OUT) $(BENCH_SRC) $(BENCH_LIBS)
+
+bench: $(BENCH_OUT)
+	./$(BENCH_OUT)
+
+$(REPLAY_OUT): $(REPLAY_SRC) $(SRC) bench/mock.h bench/swc.h
+	$(CC) -Ibench $(CFLAGS) $(BENCH_CFLAGS) $(CPPFLAGS) -o $(REPLAY_OUT) $(REPLAY_SRC) $(BENCH_LIBS)
+
+replay: $(REPLAY_OUT)
+
+# the session the bench records has to replay to the same window calls
+check: $(BENCH_OUT) $(REPLAY_OUT)
+	./$(BENCH_OUT)
+	d=$$(mktemp -d) && ./$(BENCH_OUT) -r $$d && ./$(REPLAY_OUT) -c $$d/session.trace | diff $$d/session.log -; \
+		s=$$?; rm -rf $$d; exit $$s
+
 clean:
-	rm -f $(OUT)
+	rm -f $(OUT) $(BENCH_OUT) $(REPLAY_OUT)
 
 compile_flags:
 	rm -f compile_flags.txt
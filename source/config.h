@@ -4,20 +4,64 @@
 #include <xkbcommon/xkbcommon-keysyms.h>
 
 
+#include "layout.h"
 #include "types.h"
 #include "wsxwm.h"
 
 static const struct config cfg = {
-	.motion_throttle_hz = 85,
+	.motion_idle_hz = 60, /* pointer motion cap outside of move/resize */
+	.refresh_hz = 60,     /* outputs not listed in monitors[] */
 	.border_col_active = 0xffed953e,
 	.border_col_normal = 0xff444444,
 	.border_width = 1,
 	.master_width = 60,  /* % of screen */
 	.gaps = 0,
+	.focus_delay_ms = 0, /* pointer must rest this long before focus follows, 0 = at once */
+	.trace_records = 16384, /* input trace ring, 40 bytes each, 0 = off */
+	.warm_hold_ms = 250, /* new windows wait this long for an app_id while a warm launch is out */
+	.rule_hold_ms = 0,   /* and this long otherwise while an app_id could still pick a rule, 0 = show at once */
+	.layout_settle_ms = 0, /* a layout after window churn this soon after the last one waits and takes in what follows, 0 = at once */
+};
+
+/* swc does not report output modes, so refresh rates are matched on size */
+static const struct monitor monitors[] = {
+	/* width  height  hz */
+	{ 2560,   1440,   144 },
+};
+
+/*
+ * first match in this order wins. app_id is compared first, a rule with
+ * both app_id and title needs both, one with neither matches everything
+ */
+static const struct rule rules[] = {
+	/* app_id         title  ws  screen  floating  w    h */
+	{ "pavucontrol",  NULL,  0,  -1,     1,        800, 600 },
+	{ "mpv",          NULL,  0,  -1,     1,        0,   0 },
+};
+
+/* the first layout is the default */
+static const struct layout layouts[] = {
+	/* name      fn              single */
+	{ "tile",    layout_tile,    false },
+	{ "monocle", layout_monocle, true },
+	{ "grid",    layout_grid,    false },
+	{ "columns", layout_columns, false },
+};
+
+/* per workspace layout, NULL for the default */
+static const struct layout* ws_layouts[WS_COUNT] = {
+	[8] = &layouts[1],
 };
 
 static const char* termcmd[] = { "havoc", NULL };
 static const char* menucmd[] = { "neumenu_run", NULL };
+
+/* spawn() of one of these commands shows an instance started beforehand */
+static const struct warm_pool warm_pools[] = {
+	/* app_id   command  size  refill_ms  max_rss_kb  wait_ms */
+	{ "havoc",  termcmd, 0,    500,       65536,      2000 },
+};
+
 static struct bind binds[] = {
 	/* keyboard */
 	{ SWC_BINDING_KEY,    MOD4,       XKB_KEY_Return, { .v = termcmd }, spawn },
@@ -28,10 +72,28 @@ static struct bind binds[] = {
 	{ SWC_BINDING_KEY,    MOD4|SHFT,  XKB_KEY_q,      { .v = NULL },    kill_sel },
 	{ SWC_BINDING_KEY,    MOD4,       XKB_KEY_space,  { .v = NULL },    toggle_float },
 	{ SWC_BINDING_KEY,    MOD4|SHFT,  XKB_KEY_space,  { .v = NULL },    toggle_float_global },
+	{ SWC_BINDING_KEY,    MOD4,       XKB_KEY_f,      { .v = NULL },    toggle_fullscreen },
 	{ SWC_BINDING_KEY,    MOD4,       XKB_KEY_l,      { .i = 50 },      master_resize },
 	{ SWC_BINDING_KEY,    MOD4,       XKB_KEY_h,      { .i = -50 },     master_resize },
 	{ SWC_BINDING_KEY,    MOD4|SHFT,  XKB_KEY_k,      { .v = NULL },    master_next },
 	{ SWC_BINDING_KEY,    MOD4|SHFT,  XKB_KEY_j,      { .v = NULL },    master_prev },
+	{ SWC_BINDING_KEY,    MOD4,       XKB_KEY_t,      { .v = &layouts[0] }, set_layout },
+	{ SWC_BINDING_KEY,    MOD4,       XKB_KEY_m,      { .v = &layouts[1] }, set_layout },
+	{ SWC_BINDING_KEY,    MOD4,       XKB_KEY_g,      { .v = &layouts[2] }, set_layout },
+	{ SWC_BINDING_KEY,    MOD4,       XKB_KEY_c,      { .v = &layouts[3] }, set_layout },
+	{ SWC_BINDING_KEY,    MOD4,       XKB_KEY_Tab,    { .v = NULL },    cycle_layout },
+	{ SWC_BINDING_KEY,    MOD4|CTRL,  XKB_KEY_Left,   { .u = DIR_LEFT },  focus_dir },
+	{ SWC_BINDING_KEY,    MOD4|CTRL,  XKB_KEY_Right,  { .u = DIR_RIGHT }, focus_dir },
+	{ SWC_BINDING_KEY,    MOD4|CTRL,  XKB_KEY_Up,     { .u = DIR_UP },    focus_dir },
+	{ SWC_BINDING_KEY,    MOD4|CTRL,  XKB_KEY_Down,   { .u = DIR_DOWN },  focus_dir },
+	{ SWC_BINDING_KEY,    MOD4|SHFT,  XKB_KEY_Left,   { .u = DIR_LEFT },  swap_dir },
+	{ SWC_BINDING_KEY,    MOD4|SHFT,  XKB_KEY_Right,  { .u = DIR_RIGHT }, swap_dir },
+	{ SWC_BINDING_KEY,    MOD4|SHFT,  XKB_KEY_Up,     { .u = DIR_UP },    swap_dir },
+	{ SWC_BINDING_KEY,    MOD4|SHFT,  XKB_KEY_Down,   { .u = DIR_DOWN },  swap_dir },
+	{ SWC_BINDING_KEY,    MOD4|MOD1,  XKB_KEY_Left,   { .u = DIR_LEFT },  move_dir },
+	{ SWC_BINDING_KEY,    MOD4|MOD1,  XKB_KEY_Right,  { .u = DIR_RIGHT }, move_dir },
+	{ SWC_BINDING_KEY,    MOD4|MOD1,  XKB_KEY_Up,     { .u = DIR_UP },    move_dir },
+	{ SWC_BINDING_KEY,    MOD4|MOD1,  XKB_KEY_Down,   { .u = DIR_DOWN },  move_dir },
 
 	/* mouse */
 	{ SWC_BINDING_BUTTON, MOD4,       BTN_LEFT,       { .v = NULL },    mouse_move },
@@ -56,6 +118,30 @@ static struct bind binds[] = {
 	{ SWC_BINDING_KEY,    MOD4|SHFT,  XKB_KEY_7,      { .u = 7 },       workspace_moveto },
 	{ SWC_BINDING_KEY,    MOD4|SHFT,  XKB_KEY_8,      { .u = 8 },       workspace_moveto },
 	{ SWC_BINDING_KEY,    MOD4|SHFT,  XKB_KEY_9,      { .u = 9 },       workspace_moveto },
+
+	/* tags, masks of bit workspace - 1 */
+	{ SWC_BINDING_KEY,    MOD4,       XKB_KEY_0,      { .u = ~0u },     view },
+	{ SWC_BINDING_KEY,    MOD4|SHFT,  XKB_KEY_0,      { .u = ~0u },     tag },
+	{ SWC_BINDING_KEY,    MOD4,       XKB_KEY_Right,  { .i = 1 },       workspace_cycle },
+	{ SWC_BINDING_KEY,    MOD4,       XKB_KEY_Left,   { .i = -1 },      workspace_cycle },
+	{ SWC_BINDING_KEY,    MOD4|CTRL,  XKB_KEY_1,      { .u = 1 << 0 },  toggle_view },
+	{ SWC_BINDING_KEY,    MOD4|CTRL,  XKB_KEY_2,      { .u = 1 << 1 },  toggle_view },
+	{ SWC_BINDING_KEY,    MOD4|CTRL,  XKB_KEY_3,      { .u = 1 << 2 },  toggle_view },
+	{ SWC_BINDING_KEY,    MOD4|CTRL,  XKB_KEY_4,      { .u = 1 << 3 },  toggle_view },
+	{ SWC_BINDING_KEY,    MOD4|CTRL,  XKB_KEY_5,      { .u = 1 << 4 },  toggle_view },
+	{ SWC_BINDING_KEY,    MOD4|CTRL,  XKB_KEY_6,      { .u = 1 << 5 },  toggle_view },
+	{ SWC_BINDING_KEY,    MOD4|CTRL,  XKB_KEY_7,      { .u = 1 << 6 },  toggle_view },
+	{ SWC_BINDING_KEY,    MOD4|CTRL,  XKB_KEY_8,      { .u = 1 << 7 },  toggle_view },
+	{ SWC_BINDING_KEY,    MOD4|CTRL,  XKB_KEY_9,      { .u = 1 << 8 },  toggle_view },
+	{ SWC_BINDING_KEY,    MOD4|CTRL|SHFT, XKB_KEY_1,  { .u = 1 << 0 },  toggle_tag },
+	{ SWC_BINDING_KEY,    MOD4|CTRL|SHFT, XKB_KEY_2,  { .u = 1 << 1 },  toggle_tag },
+	{ SWC_BINDING_KEY,    MOD4|CTRL|SHFT, XKB_KEY_3,  { .u = 1 << 2 },  toggle_tag },
+	{ SWC_BINDING_KEY,    MOD4|CTRL|SHFT, XKB_KEY_4,  { .u = 1 << 3 },  toggle_tag },
+	{ SWC_BINDING_KEY,    MOD4|CTRL|SHFT, XKB_KEY_5,  { .u = 1 << 4 },  toggle_tag },
+	{ SWC_BINDING_KEY,    MOD4|CTRL|SHFT, XKB_KEY_6,  { .u = 1 << 5 },  toggle_tag },
+	{ SWC_BINDING_KEY,    MOD4|CTRL|SHFT, XKB_KEY_7,  { .u = 1 << 6 },  toggle_tag },
+	{ SWC_BINDING_KEY,    MOD4|CTRL|SHFT, XKB_KEY_8,  { .u = 1 << 7 },  toggle_tag },
+	{ SWC_BINDING_KEY,    MOD4|CTRL|SHFT, XKB_KEY_9,  { .u = 1 << 8 },  toggle_tag },
 };
 
 #endif /* CONFIG_H */
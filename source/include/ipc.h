@@ -0,0 +1,12 @@
+#ifndef IPC_H
+#define IPC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+void ipc_finish(void);
+void ipc_init(const char* display);
+void ipc_publish(const char* buf, size_t len);
+bool ipc_subscribed(void);
+
+#endif /* IPC_H */
@@ -0,0 +1,22 @@
+#ifndef LAUNCH_H
+#define LAUNCH_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <wayland-util.h>
+
+struct child {
+	struct wl_list link;
+	pid_t          pid;
+	uint64_t       started;
+	void*          data;
+	void           (*exited)(struct child* ch);  /* called before it is freed */
+};
+
+struct child* launch_find(pid_t pid);
+void launch_finish(void);
+void launch_init(void);
+struct child* launch_spawn(char* const* argv, uint32_t time);
+
+#endif /* LAUNCH_H */
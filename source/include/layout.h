@@ -0,0 +1,13 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+void layout_columns(const struct layout_params* p, size_t n, struct swc_rectangle* out);
+void layout_grid(const struct layout_params* p, size_t n, struct swc_rectangle* out);
+void layout_monocle(const struct layout_params* p, size_t n, struct swc_rectangle* out);
+void layout_tile(const struct layout_params* p, size_t n, struct swc_rectangle* out);
+
+#endif /* LAYOUT_H */
@@ -0,0 +1,41 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <wayland-server.h>
+
+#define LOG_ERR   0
+#define LOG_WARN  1
+#define LOG_INFO  2
+#define LOG_DEBUG 3
+
+/* records above this are not compiled in, -DLOG_LEVEL=3 for debug */
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_INFO
+#endif
+
+#define log_err(...) log_emit(LOG_ERR, __VA_ARGS__)
+
+#if LOG_LEVEL >= LOG_WARN
+#define log_warn(...) log_emit(LOG_WARN, __VA_ARGS__)
+#else
+#define log_warn(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_INFO
+#define log_info(...) log_emit(LOG_INFO, __VA_ARGS__)
+#else
+#define log_info(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_DEBUG
+#define log_debug(...) log_emit(LOG_DEBUG, __VA_ARGS__)
+#else
+#define log_debug(...) ((void)0)
+#endif
+
+void log_emit(int level, const char* fmt, ...);
+void log_finish(void);
+void log_flush(void);
+void log_init(struct wl_event_loop* loop);
+
+#endif /* LOG_H */
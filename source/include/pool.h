@@ -0,0 +1,19 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "types.h"
+
+void* pool_alloc(struct pool* p, struct handle* h);
+void pool_finish(struct pool* p);
+void pool_free(struct pool* p, struct handle h);
+void* pool_get(const struct pool* p, struct handle h);
+void pool_init(struct pool* p, size_t size, size_t per_slab);
+
+#define HANDLE_NONE ((struct handle){ 0, 0 })
+#define HANDLE_EQ(a, b) ((a).idx == (b).idx && (a).gen == (b).gen)
+
+#endif /* POOL_H */
@@ -0,0 +1,14 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "types.h"
+
+bool rules_await_app_id(const struct rule_index* ri, const struct rule* r);
+void rules_finish(struct rule_index* ri);
+void rules_init(struct rule_index* ri, const struct rule* rules, size_t n);
+const struct rule* rules_match(const struct rule_index* ri, const char* app_id, const char* title);
+
+#endif /* RULES_H */
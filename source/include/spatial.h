@@ -0,0 +1,16 @@
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <swc.h>
+
+#include "types.h"
+
+void spatial_finish(struct spatial* sp);
+struct client* spatial_neighbour(struct screen* s, const struct client* self,
+	const struct swc_rectangle* from, uint32_t dir);
+bool spatial_snap(struct screen* s, int32_t edge, int32_t slack, uint32_t dir, int32_t* out);
+
+#endif /* SPATIAL_H */
@@ -0,0 +1,49 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* 4 linear sub-buckets per power of two, up to ~1100s in ns */
+enum {
+	HIST_BUCKETS = 160,
+};
+
+enum {
+	STAT_TILE,
+	STAT_FOCUS,
+	STAT_NEW_WINDOW,
+	STAT_WIN_DESTROY,
+	STAT_WIN_ENTERED,
+	STAT_NEW_SCREEN,
+	STAT_SCREEN_GEOMETRY,
+	STAT_SPAWN,
+	STAT_SPAWN_INPUT,
+	STAT_COUNT,
+};
+
+struct hist {
+	const char*    name;
+	uint64_t       count;
+	uint64_t       sum;
+	uint64_t       max;
+	uint32_t       buckets[HIST_BUCKETS];
+};
+
+extern struct hist stats[STAT_COUNT];
+
+void hist_dump(const struct hist* h, FILE* fd);
+void hist_header(FILE* fd, const char* what);
+uint64_t hist_percentile(const struct hist* h, double p);
+void hist_record(struct hist* h, uint64_t ns);
+void stats_dump(FILE* fd);
+uint64_t stats_input_age(uint32_t time, uint64_t now);
+uint64_t stats_now(void);
+
+#define TIMED(h, call) do { \
+	uint64_t _t0 = stats_now(); \
+	call; \
+	hist_record((h), stats_now() - _t0); \
+} while (0)
+
+#endif /* STATS_H */
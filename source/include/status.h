@@ -0,0 +1,10 @@
+#ifndef STATUS_H
+#define STATUS_H
+
+#include <stdio.h>
+
+void status_finish(void);
+void status_touch(void);
+void status_write(FILE* out);
+
+#endif /* STATUS_H */
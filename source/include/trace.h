@@ -0,0 +1,79 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <swc.h>
+
+#define TRACE_MAGIC   "WSXTRACE"
+#define TRACE_VERSION 3
+
+enum {
+	TRACE_NEW_SCREEN,
+	TRACE_SCREEN_DESTROY,
+	TRACE_SCREEN_GEOMETRY,
+	TRACE_SCREEN_USABLE,
+	TRACE_SCREEN_ENTERED,
+	TRACE_NEW_WINDOW,
+	TRACE_WIN_DESTROY,
+	TRACE_WIN_ENTERED,
+	TRACE_BIND,
+	TRACE_ACTION,
+	TRACE_WIN_APP_ID,
+	TRACE_TYPES,
+};
+
+/* index of a TRACE_SCREEN_USABLE that only completes a TRACE_NEW_SCREEN */
+enum {
+	TRACE_USABLE_INITIAL = 1,
+};
+
+/* flags of a window record */
+enum {
+	TRACE_HAS_APP_ID = 1 << 0,  /* whatever it was, the rules may not have matched it */
+};
+
+/*
+ * obj is the swc_window or swc_screen pointer, unique among live objects,
+ * so a replay maps it to whatever it created for the matching new record
+ */
+struct trace_rec {
+	uint64_t       t;           /* ns since trace_init */
+	uint64_t       obj;
+	union {
+		struct swc_rectangle geom;
+		struct {
+			uint32_t time;
+			uint32_t value;
+			uint32_t state;
+			int32_t  arg;       /* int, uint or layout index of an action */
+		} input;
+	} u;
+	uint16_t       index;       /* binds[] or actions[] index, rules[] index + 1 for windows */
+	uint8_t        type;
+	uint8_t        flags;
+};
+
+/* file layout: header, then count records oldest first */
+struct trace_header {
+	char           magic[8];
+	uint32_t       version;
+	uint32_t       rec_size;
+	uint32_t       nbinds;
+	uint32_t       nactions;
+	uint32_t       nrules;
+	uint64_t       count;
+	uint64_t       dropped;     /* overwritten before the dump, replay starts mid-session */
+};
+
+extern const char* trace_names[TRACE_TYPES];
+
+int trace_dump(const char* path, uint32_t nbinds, uint32_t nactions, uint32_t nrules);
+void trace_finish(void);
+void trace_init(size_t cap);
+void trace_input(uint8_t type, uint16_t index, uint32_t time, uint32_t value, uint32_t state, int32_t arg);
+void trace_screen(uint8_t type, const struct swc_screen* scr, const struct swc_rectangle* geom, uint16_t index);
+void trace_window(uint8_t type, const struct swc_window* win, uint16_t index);
+
+#endif /* TRACE_H */
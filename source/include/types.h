@@ -2,6 +2,7 @@
 #define TYPES_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <swc.h>
@@ -13,6 +14,36 @@ enum {
 	BTN_MIDDLE = 0x112,
 };
 
+enum {
+	WS_COUNT   = 9,
+	TAG_ALL    = (1 << WS_COUNT) - 1,
+};
+
+enum {
+	MODE_UNSET   = 0,
+	MODE_TILED   = 1,
+	MODE_STACKED = 2,
+	MODE_FULLSCREEN = 3,
+};
+
+/* how an action reads its union arg when invoked by name */
+enum {
+	ARG_NONE,
+	ARG_INT,
+	ARG_UINT,
+	ARG_CMD,
+	ARG_LAYOUT,
+	ARG_POINTER, /* pointer grabs, only usable from a binding */
+	ARG_DIR,     /* left, right, up or down */
+};
+
+enum {
+	DIR_LEFT,
+	DIR_RIGHT,
+	DIR_UP,
+	DIR_DOWN,
+};
+
 enum {
 	MOD1 = SWC_MOD_ALT,
 	MOD4 = SWC_MOD_LOGO,
@@ -27,6 +58,12 @@ union arg {
 	const void*    v;
 };
 
+struct action {
+	const char*    name;
+	void           (*fn)(void* data, uint32_t time, uint32_t value, uint32_t state);
+	uint8_t        arg;
+};
+
 struct bind {
 	uint32_t       type;
 	uint32_t       mods;
@@ -35,60 +72,243 @@ struct bind {
 	void           (*fn)(void* data, uint32_t time, uint32_t value, uint32_t state);
 };
 
+/* a bind whose layout pass has not gone out yet */
+struct input_pending {
+	uint32_t       time;        /* of the input event, ms */
+	uint32_t       action;
+};
+
+/* last state sent to swc, used to drop redundant requests */
+struct shadow {
+	struct swc_rectangle geom;
+	uint32_t       border_col;
+	uint32_t       border_width;
+	uint8_t        mode;
+	bool           geom_valid;
+	bool           border_valid;
+	uint64_t       stack_seq;   /* wm.stack_seq when last stacked, higher is on top */
+};
+
+struct handle {
+	uint32_t       idx;
+	uint32_t       gen;
+};
+
 struct client {
+	/* filter fields first, scans stay within the first cache line */
+	uint32_t       ws;          /* lowest tag, the workspace whose lists hold it */
+	uint32_t       tags;        /* bit ws - 1 per workspace it is on, 0 while unmapped */
+	struct handle  scr;
+	struct handle  over;        /* fullscreen client it was mapped above, shown with it */
+	bool           floating;
+	bool           fullscreen;
+	bool           mapped;
+	bool           ruled;       /* rules were looked up with an app_id */
+	bool           show_pending;  /* mapped, shown by the layout pass that sizes it */
+	bool           covered;     /* hidden by a single layout, whatever the tags say */
+	uint8_t        warm;        /* warm pool index + 1 while parked */
+	struct handle  id;
 	struct wl_list tiled_link;
 	struct wl_list float_link;
+	struct wl_list stack_link;
 	struct swc_window* win;
-	struct screen* scr;
-	bool           mapped;
-	bool           floating;
-	bool           fullscreen;
-	int32_t        x;
+	struct swc_rectangle home;  /* output it was moved off, width 0 if none */
+	int32_t        x;           /* floating geometry to return to after fullscreen */
 	int32_t        y;
 	uint32_t       w;
 	uint32_t       h;
-	uint32_t       ws;
+	uint64_t       held_until;  /* stats_now() it is shown by while on wm.held */
+	struct shadow  sent;
 };
 
 struct config {
-	uint32_t       motion_throttle_hz;
+	uint32_t       motion_idle_hz;
+	uint32_t       refresh_hz;
 	uint32_t       master_width;
 	uint32_t       master_resize;
 	uint32_t       border_col_active;
 	uint32_t       border_col_normal;
 	uint32_t       border_width;
 	uint32_t       gaps;
+	uint32_t       focus_delay_ms;
+	uint32_t       trace_records;
+	uint32_t       warm_hold_ms;
+	uint32_t       rule_hold_ms;
+	uint32_t       layout_settle_ms;
+};
+
+/* input of a layout function, everything it may depend on */
+struct layout_params {
+	struct swc_rectangle area;
+	uint32_t       gaps;
+	uint32_t       border_width;
+	uint32_t       master_width;
+};
+
+/* fills out[0..n-1] with the geometry of the n tiled clients, in list order */
+struct layout {
+	const char*    name;
+	void           (*fn)(const struct layout_params* p, size_t n, struct swc_rectangle* out);
+	bool           single;      /* only the focused tiled client is shown, the rest are hidden */
+};
+
+/* floating is focus-cycle order, stack is z-order with the topmost first */
+struct workspace {
+	struct wl_list tiled;
+	struct wl_list floating;
+	struct wl_list stack;
+	const struct layout* layout;
+};
+
+/* kept up to date by attach() and detach(), a bit is set while its count is */
+struct occupancy {
+	uint32_t       mask;        /* tags with at least one client */
+	uint32_t       multi;       /* workspaces holding a client with several tags */
+	uint16_t       count[WS_COUNT];
+	uint16_t       nmulti[WS_COUNT];
+};
+
+/* NULL app_id and title match anything, ws 0 and screen -1 keep the default */
+struct rule {
+	const char*    app_id;
+	const char*    title;
+	uint32_t       ws;
+	int32_t        screen;      /* in the order screens appeared */
+	int8_t         floating;    /* -1 keep, 0 tiled, 1 floating */
+	uint32_t       w;           /* floating size, 0 to let the client pick */
+	uint32_t       h;
+};
+
+/* commands kept started ahead of time, see warm.c */
+struct warm_pool {
+	const char*    app_id;      /* how its windows are recognised */
+	const char* const* argv;    /* spawn() with this command takes an instance */
+	uint32_t       size;        /* instances kept ready, 0 = off */
+	uint32_t       refill_ms;   /* delay before replacing one that was taken */
+	uint32_t       max_rss_kb;  /* no new instance while the ready ones use this, 0 = no cap */
+	uint32_t       wait_ms;     /* a launch whose window takes longer is given up on */
+};
+
+struct rule_index {
+	const struct rule* rules;
+	size_t         n;
+	size_t         cap;         /* slots per table, a power of two */
+	uint32_t*      app_slots;
+	uint32_t*      title_slots;
+	uint32_t*      next;        /* next rule with the same key */
+	uint32_t       any;         /* first rule with neither key */
+	uint32_t       first_app;   /* first rule with an app_id */
+};
+
+struct counters {
+	uint64_t       geom_sent;
+	uint64_t       geom_elided;
+	uint64_t       border_sent;
+	uint64_t       border_elided;
+	uint64_t       mode_sent;
+	uint64_t       mode_elided;
+	uint64_t       layout_requested;
+	uint64_t       layout_run;
+	uint64_t       focus_noop;
+	uint64_t       focus_deferred;
+	uint64_t       focus_suppressed;
+	uint64_t       restack_sent;
+	uint64_t       restack_elided;
+	uint64_t       warm_launched;
+	uint64_t       warm_taken;
+	uint64_t       warm_missed;
+	uint64_t       status_sent;
+	uint64_t       status_elided;
+	uint64_t       log_dropped;
+	uint64_t       layout_deferred;
+};
+
+struct monitor {
+	uint32_t       width;
+	uint32_t       height;
+	uint32_t       hz;
 };
 
 struct grab {
 	bool           active;
 	bool           resize;
-	struct client* c;
+	struct handle  c;
+};
+
+/* slab storage for clients and screens, see pool.c */
+struct pool {
+	void**         slabs;
+	uint32_t*      gens;
+	size_t         nslabs;
+	size_t         per_slab;
+	size_t         size;
+	size_t         used;
+	uint32_t       free;
+};
+
+/*
+ * the clients shown on a screen by the geometry last sent for them, and
+ * their left/right and top/bottom edges sorted with the usable area's.
+ * built on the first query after wm.geom_seq moved
+ */
+struct spatial {
+	uint64_t       seq;         /* wm.geom_seq when built, 0 never */
+	size_t         n;
+	size_t         cap;
+	struct swc_rectangle* rects;
+	struct handle* ids;
+	int32_t*       xs;          /* 2n + 2 */
+	int32_t*       ys;
 };
 
 struct screen {
 	struct wl_list link;
+	struct handle  id;
 	struct swc_screen* scr;
+	struct workspace ws[WS_COUNT];
+	struct occupancy occ;
+	uint32_t       tags;        /* shown tags */
+	struct handle  fs;          /* fullscreen client, covers the rest while shown */
+	struct handle  front;       /* tiled client a single layout shows */
+	uint32_t       sel_ws;      /* lowest shown tag, its workspace has the layout */
+	uint32_t       refresh_hz;
+	bool           dirty;
 	int32_t        x;
 	int32_t        y;
 	uint32_t       w;
 	uint32_t       h;
+	struct spatial index;
 };
 
 struct wm {
 	struct wl_display* dpy;
 	struct wl_event_loop* ev_loop;
+	struct wl_event_source* layout_idle;
+	struct wl_event_source* focus_timer;
+	struct wl_event_source* hold_timer;
+	struct wl_event_source* layout_timer;
+	struct wl_event_source* sigusr1;
+	bool           layout_waiting;  /* on layout_timer rather than layout_idle */
+	uint64_t       layout_last;     /* stats_now() of the last layout pass */
+	bool           in_input;        /* a binding or control socket action is running */
 
 	struct wl_list screens;
-	struct wl_list tiled;
-	struct wl_list floating;
+	struct workspace limbo[WS_COUNT];  /* clients with no screen left */
+	struct occupancy limbo_occ;
+	struct pool    client_pool;
+	struct pool    screen_pool;
+	struct rule_index rule_index;
+	struct wl_list held;       /* new windows waiting for an app_id, by tiled_link, soonest first */
 
-	struct screen* sel_screen;
-	struct client* sel_client;
+	struct handle  sel_screen;
+	struct handle  sel_client;
 	struct grab    grab;
+	struct handle  focus_pending;
+	struct counters count;
+	uint64_t       stack_seq;
+	uint64_t       geom_seq;    /* moves whenever what is shown where may have changed */
 
 	bool           global_floating;
-	uint8_t        ws;
 };
 
 #endif /* TYPES_H */
@@ -2,6 +2,7 @@
 #define UTIL_H
 
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -10,18 +11,46 @@
 
 #include "types.h"
 
+void attach(struct client* c);
+struct client* client_at(struct handle h);
+void client_hide(struct client* c);
+void client_raise(struct client* c);
+void client_set_border(struct client* c, uint32_t col, uint32_t width);
+void client_set_fullscreen(struct client* c, struct swc_screen* scr);
+void client_set_geometry(struct client* c, const struct swc_rectangle* geom);
+void client_set_mode(struct client* c, uint8_t mode, bool force);
+void client_show(struct client* c);
+bool client_visible(const struct client* c);
+void detach(struct client* c);
 void die(int ret, const char* fmt, ...);
 struct client* first_float(struct screen* s);
 struct client* first_tiled(struct screen* s);
 bool is_float(const struct client* c, const struct screen* s);
+bool is_home(const struct client* c, const struct swc_rectangle* g);
 bool is_tiled(const struct client* c, const struct screen* s);
 struct client* last_float(struct screen* s);
 struct client* last_tiled(struct screen* s);
-void _log(FILE* fd, const char* fmt, ...);
+void log_counters(FILE* fd);
+struct client* next_float(struct screen* s, struct client* c);
+struct client* next_tiled(struct screen* s, struct client* c);
+void occupancy_move(struct occupancy* dst, struct occupancy* src);
+struct occupancy* occupancy_of(struct screen* s);
+void occupancy_update(struct occupancy* o, uint32_t tags, uint32_t ws, int delta);
+struct client* prev_float(struct screen* s, struct client* c);
+struct client* prev_tiled(struct screen* s, struct client* c);
+struct screen* screen_at(struct handle h);
+uint32_t screen_lists(const struct screen* s, uint32_t tags);
+void screen_restack(struct screen* s);
+void screen_view(struct screen* s, uint32_t tags, struct client* fs);
 void sig_handler(int s);
-void sync_window_visibility(void);
+uint32_t tag_first(uint32_t tags);
+struct client* top_float(struct screen* s);
+struct workspace* workspace_cur(struct screen* s);
+struct workspace* workspace_of(struct screen* s, uint32_t ws);
+void workspace_restack(struct workspace* w);
 
 #define LENGTH(x) (sizeof(x) / sizeof((x)[0]))
+#define TAG(ws)   (1u << ((ws) - 1))
 
 #endif /* UTIL_H */
 
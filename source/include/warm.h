@@ -0,0 +1,16 @@
+#ifndef WARM_H
+#define WARM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "types.h"
+
+void warm_finish(void);
+void warm_init(const struct warm_pool* pools, size_t n);
+bool warm_park(struct client* c);
+bool warm_pending(void);
+void warm_release(struct client* c);
+struct client* warm_take(char* const* argv);
+
+#endif /* WARM_H */
@@ -2,9 +2,17 @@
 #define WSXWM_H
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include "types.h"
 
+extern void cycle_layout(void* data, uint32_t time, uint32_t value, uint32_t state);
+extern void dump_latency(FILE* fd);
+extern void dump_stats(FILE* fd);
+extern int dump_trace(const char* path);
+extern const struct action* find_action(const char* name);
+extern const struct layout* find_layout(const char* name);
+extern void focus_dir(void* data, uint32_t time, uint32_t value, uint32_t state);
 extern void focus_next(void* data, uint32_t time, uint32_t value, uint32_t state);
 extern void focus_prev(void* data, uint32_t time, uint32_t value, uint32_t state);
 extern void kill_sel(void* data, uint32_t time, uint32_t value, uint32_t state);
@@ -13,13 +21,23 @@ extern void master_prev(void* data, uint32_t time, uint32_t value, uint32_t stat
 extern void master_resize(void* data, uint32_t time, uint32_t value, uint32_t state);
 extern void mouse_move(void* data, uint32_t time, uint32_t value, uint32_t state);
 extern void mouse_resize(void* data, uint32_t time, uint32_t value, uint32_t state);
+extern void move_dir(void* data, uint32_t time, uint32_t value, uint32_t state);
 extern void new_screen(struct swc_screen* scr);
 extern void new_window(struct swc_window* win);
 extern void new_device(struct libinput_device* dev);
 extern void quit(void* data, uint32_t time, uint32_t value, uint32_t state);
+extern void run_action(const struct action* a, union arg* arg, uint32_t time);
+extern void set_layout(void* data, uint32_t time, uint32_t value, uint32_t state);
 extern void spawn(void* data, uint32_t time, uint32_t value, uint32_t state);
+extern void swap_dir(void* data, uint32_t time, uint32_t value, uint32_t state);
+extern void tag(void* data, uint32_t time, uint32_t value, uint32_t state);
 extern void toggle_float(void* data, uint32_t time, uint32_t value, uint32_t state);
 extern void toggle_float_global(void* data, uint32_t time, uint32_t value, uint32_t state);
+extern void toggle_fullscreen(void* data, uint32_t time, uint32_t value, uint32_t state);
+extern void toggle_tag(void* data, uint32_t time, uint32_t value, uint32_t state);
+extern void toggle_view(void* data, uint32_t time, uint32_t value, uint32_t state);
+extern void view(void* data, uint32_t time, uint32_t value, uint32_t state);
+extern void workspace_cycle(void* data, uint32_t time, uint32_t value, uint32_t state);
 extern void workspace_goto(void* data, uint32_t time, uint32_t value, uint32_t state);
 extern void workspace_moveto(void* data, uint32_t time, uint32_t value, uint32_t state);
 
@@ -0,0 +1,566 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <wayland-server.h>
+
+#include "ipc.h"
+#include "log.h"
+#include "stats.h"
+#include "status.h"
+#include "types.h"
+#include "util.h"
+#include "wsxwm.h"
+
+/*
+ * line based control socket at $XDG_RUNTIME_DIR/wsxwm-$WAYLAND_DISPLAY.sock.
+ * each line is an action name with its argument ("workspace_goto 3") or a
+ * query (clients, focus, latency, screens, status, workspaces, stats, trace).
+ * every read is handled in one go, so the layout pass runs once after all of
+ * its commands. "subscribe" keeps the connection for status lines, see status.c;
+ * output a client does not take at once is queued up to IPC_OUT_MAX.
+ */
+
+enum {
+	IPC_BUF     = 4096,
+	IPC_ARGS    = 32,
+	IPC_OUT_MAX = 65536,
+};
+
+struct ipc_client {
+	struct wl_list link;
+	struct wl_event_source* src;
+	int            fd;
+	uint32_t       mask;        /* event loop mask in effect */
+	bool           subscribed;
+	bool           rd_closed;   /* peer shut down its writing side */
+	char*          out;         /* queued output */
+	size_t         out_len;
+	size_t         len;
+	char           buf[IPC_BUF];
+};
+
+struct query {
+	const char*    name;
+	void           (*fn)(FILE* out);
+};
+
+static void client_close(struct ipc_client* ic);
+static bool client_flush(struct ipc_client* ic);
+static bool client_send(struct ipc_client* ic, const char* buf, size_t len);
+static void client_watch(struct ipc_client* ic);
+static void exec_line(struct ipc_client* ic, char* line, FILE* out);
+static int find_dir(const char* name);
+static void for_each_client(void (*fn)(const struct client* c, FILE* out), FILE* out);
+static int on_accept(int fd, uint32_t mask, void* data);
+static int on_readable(int fd, uint32_t mask, void* data);
+static void print_client(const struct client* c, FILE* out);
+static void query_clients(FILE* out);
+static void query_focus(FILE* out);
+static void query_latency(FILE* out);
+static void query_screens(FILE* out);
+static void query_stats(FILE* out);
+static void query_status(FILE* out);
+static void query_trace(FILE* out);
+static void query_workspaces(FILE* out);
+static int set_flags(int fd);
+
+static const char* const dir_names[] = {
+	[DIR_LEFT]  = "left",
+	[DIR_RIGHT] = "right",
+	[DIR_UP]    = "up",
+	[DIR_DOWN]  = "down",
+};
+
+static const struct query queries[] = {
+	{ "clients",    query_clients },
+	{ "focus",      query_focus },
+	{ "latency",    query_latency },
+	{ "screens",    query_screens },
+	{ "stats",      query_stats },
+	{ "status",     query_status },
+	{ "trace",      query_trace },
+	{ "workspaces", query_workspaces },
+};
+
+static struct wl_list clients;
+static size_t subscribers = 0;
+static struct wl_event_source* listen_src = NULL;
+static int listen_fd = -1;
+static char sock_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+
+static void client_close(struct ipc_client* ic)
+{
+	if (ic->subscribed)
+		subscribers--;
+	wl_event_source_remove(ic->src);
+	wl_list_remove(&ic->link);
+	close(ic->fd);
+	free(ic->out);
+	free(ic);
+}
+
+/* false if the peer is gone */
+static bool client_flush(struct ipc_client* ic)
+{
+	size_t off = 0;
+
+	while (off < ic->out_len) {
+		ssize_t n = send(ic->fd, ic->out + off, ic->out_len - off, MSG_NOSIGNAL);
+
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && errno == EAGAIN)
+			break;
+		if (n <= 0)
+			return false;
+		off += (size_t)n;
+	}
+
+	ic->out_len -= off;
+	memmove(ic->out, ic->out + off, ic->out_len);
+	client_watch(ic);
+	return true;
+}
+
+/* false if the peer is gone or too far behind */
+static bool client_send(struct ipc_client* ic, const char* buf, size_t len)
+{
+	char* out;
+
+	if (len == 0)
+		return true;
+	if (ic->out_len + len > IPC_OUT_MAX)
+		return false;
+
+	out = realloc(ic->out, ic->out_len + len);
+	if (!out)
+		return false;
+
+	ic->out = out;
+	memcpy(ic->out + ic->out_len, buf, len);
+	ic->out_len += len;
+	return client_flush(ic);
+}
+
+static void client_watch(struct ipc_client* ic)
+{
+	uint32_t mask = ic->rd_closed ? 0 : WL_EVENT_READABLE;
+
+	if (ic->out_len)
+		mask |= WL_EVENT_WRITABLE;
+	if (mask != ic->mask)
+		wl_event_source_fd_update(ic->src, mask);
+	ic->mask = mask;
+}
+
+static void exec_line(struct ipc_client* ic, char* line, FILE* out)
+{
+	const struct action* a;
+	char* argv[IPC_ARGS + 1];
+	char* end;
+	size_t argc = 0;
+	union arg arg = { .v = NULL };
+
+	for (char* tok = strtok(line, " \t\r"); tok && argc < IPC_ARGS; tok = strtok(NULL, " \t\r"))
+		argv[argc++] = tok;
+	argv[argc] = NULL;
+
+	if (argc == 0)
+		return;
+
+	/* the current status now, then a line whenever it changes */
+	if (strcmp(argv[0], "subscribe") == 0) {
+		if (!ic->subscribed)
+			subscribers++;
+		ic->subscribed = true;
+		status_write(out);
+		return;
+	}
+
+	for (size_t i = 0; i < LENGTH(queries); i++) {
+		if (strcmp(queries[i].name, argv[0]) == 0) {
+			queries[i].fn(out);
+			return;
+		}
+	}
+
+	a = find_action(argv[0]);
+	if (!a || a->arg == ARG_POINTER) {
+		fprintf(out, "error: unknown command %s\n", argv[0]);
+		return;
+	}
+
+	switch (a->arg) {
+	case ARG_INT:
+	case ARG_UINT:
+		if (argc < 2) {
+			fprintf(out, "error: %s needs an argument\n", argv[0]);
+			return;
+		}
+		errno = 0;
+		if (a->arg == ARG_INT)
+			arg.i = (int)strtol(argv[1], &end, 10);
+		else
+			arg.u = (uint32_t)strtoul(argv[1], &end, 10);
+		if (errno || *end) {
+			fprintf(out, "error: bad argument %s\n", argv[1]);
+			return;
+		}
+		break;
+	case ARG_LAYOUT:
+		arg.v = argc < 2 ? NULL : find_layout(argv[1]);
+		if (!arg.v) {
+			fprintf(out, "error: %s needs a layout name\n", argv[0]);
+			return;
+		}
+		break;
+	case ARG_CMD:
+		if (argc < 2) {
+			fprintf(out, "error: %s needs a command\n", argv[0]);
+			return;
+		}
+		arg.v = &argv[1];
+		break;
+	case ARG_DIR:
+		if (argc < 2 || find_dir(argv[1]) < 0) {
+			fprintf(out, "error: %s needs left, right, up or down\n", argv[0]);
+			return;
+		}
+		arg.u = (uint32_t)find_dir(argv[1]);
+		break;
+	}
+
+	run_action(a, &arg, (uint32_t)(stats_now() / 1000000));
+	fprintf(out, "ok\n");
+}
+
+static int find_dir(const char* name)
+{
+	for (size_t i = 0; i < LENGTH(dir_names); i++) {
+		if (strcmp(dir_names[i], name) == 0)
+			return (int)i;
+	}
+
+	return -1;
+}
+
+static void for_each_client(void (*fn)(const struct client* c, FILE* out), FILE* out)
+{
+	struct client* c;
+	struct screen* s;
+
+	wl_list_for_each(s, &wm.screens, link) {
+		for (uint32_t i = 0; i < WS_COUNT; i++) {
+			wl_list_for_each(c, &s->ws[i].tiled, tiled_link)
+				fn(c, out);
+			wl_list_for_each(c, &s->ws[i].floating, float_link)
+				fn(c, out);
+		}
+	}
+}
+
+static int on_accept(int fd, uint32_t mask, void* data)
+{
+	struct ipc_client* ic;
+	int cfd;
+
+	(void)mask;
+	(void)data;
+
+	cfd = accept(fd, NULL, NULL);
+	if (cfd < 0)
+		return 0;
+
+	ic = calloc(1, sizeof(*ic));
+	if (!ic || set_flags(cfd) < 0) {
+		free(ic);
+		close(cfd);
+		return 0;
+	}
+
+	ic->fd = cfd;
+	ic->mask = WL_EVENT_READABLE;
+	ic->src = wl_event_loop_add_fd(wm.ev_loop, cfd, WL_EVENT_READABLE, on_readable, ic);
+	if (!ic->src) {
+		free(ic);
+		close(cfd);
+		return 0;
+	}
+
+	wl_list_insert(&clients, &ic->link);
+	return 0;
+}
+
+static int on_readable(int fd, uint32_t mask, void* data)
+{
+	struct ipc_client* ic = data;
+	char* reply = NULL;
+	size_t reply_len = 0;
+	bool hup = (mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR)) != 0;
+	bool eof = hup;
+	FILE* out;
+
+	if ((mask & WL_EVENT_WRITABLE) && !client_flush(ic)) {
+		client_close(ic);
+		return 0;
+	}
+
+	/* a peer that shut its writing side stays until its output is out */
+	if (ic->rd_closed) {
+		if (hup || (!ic->out_len && !ic->subscribed))
+			client_close(ic);
+		return 0;
+	}
+	if (!(mask & WL_EVENT_READABLE) && !hup)
+		return 0;
+
+	for (;;) {
+		ssize_t n = read(fd, ic->buf + ic->len, sizeof(ic->buf) - 1 - ic->len);
+
+		if (n > 0) {
+			ic->len += (size_t)n;
+			if (ic->len == sizeof(ic->buf) - 1)
+				break;
+		}
+		else if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+			eof = true;
+			break;
+		}
+		else if (errno == EAGAIN) {
+			break;
+		}
+	}
+
+	out = open_memstream(&reply, &reply_len);
+	if (!out) {
+		client_close(ic);
+		return 0;
+	}
+
+	/* run every complete line, keep a trailing partial one for later */
+	char* start = ic->buf;
+	char* nl;
+	ic->buf[ic->len] = '\0';
+	while ((nl = memchr(start, '\n', ic->len - (size_t)(start - ic->buf)))) {
+		*nl = '\0';
+		exec_line(ic, start, out);
+		start = nl + 1;
+	}
+
+	ic->len -= (size_t)(start - ic->buf);
+	memmove(ic->buf, start, ic->len);
+
+	/* unterminated final line or an over-long one */
+	if ((eof || ic->len == sizeof(ic->buf) - 1) && ic->len > 0) {
+		ic->buf[ic->len] = '\0';
+		exec_line(ic, ic->buf, out);
+		ic->len = 0;
+	}
+
+	fclose(out);
+
+	if (hup || !client_send(ic, reply, reply_len)) {
+		free(reply);
+		client_close(ic);
+		return 0;
+	}
+	free(reply);
+
+	if (eof) {
+		ic->rd_closed = true;
+		if (!ic->out_len && !ic->subscribed)
+			client_close(ic);
+		else
+			client_watch(ic);
+	}
+
+	return 0;
+}
+
+static void print_client(const struct client* c, FILE* out)
+{
+	const struct shadow* sh = &c->sent;
+
+	fprintf(out, "%p ws=%u tags=%#x floating=%d fullscreen=%d focused=%d geometry=%d,%d,%ux%u app_id=%s title=%s\n",
+		(void*)c, c->ws, c->tags, c->floating, c->fullscreen, c == client_at(wm.sel_client),
+		sh->geom.x, sh->geom.y, sh->geom.width, sh->geom.height,
+		c->win->app_id ? c->win->app_id : "",
+		c->win->title ? c->win->title : "");
+}
+
+static void query_clients(FILE* out)
+{
+	for_each_client(print_client, out);
+}
+
+static void query_focus(FILE* out)
+{
+	struct client* c = client_at(wm.sel_client);
+
+	if (c)
+		print_client(c, out);
+	else
+		fprintf(out, "none\n");
+}
+
+static void query_latency(FILE* out)
+{
+	dump_latency(out);
+}
+
+static void query_screens(FILE* out)
+{
+	struct screen* s;
+
+	wl_list_for_each(s, &wm.screens, link) {
+		const struct swc_rectangle* g = &s->scr->geometry;
+		const struct swc_rectangle* u = &s->scr->usable_geometry;
+
+		fprintf(out, "%p geometry=%d,%d,%ux%u usable=%d,%d,%ux%u workspace=%u tags=%#x occupied=%#x selected=%d\n",
+			(void*)s, g->x, g->y, g->width, g->height,
+			u->x, u->y, u->width, u->height, s->sel_ws, s->tags, s->occ.mask,
+			s == screen_at(wm.sel_screen));
+	}
+}
+
+static void query_stats(FILE* out)
+{
+	dump_stats(out);
+}
+
+static void query_status(FILE* out)
+{
+	status_write(out);
+}
+
+/* the trace goes next to the socket, wsxwm-$WAYLAND_DISPLAY.trace */
+static void query_trace(FILE* out)
+{
+	char path[sizeof(sock_path)];
+	size_t len = strlen(sock_path);
+	int n;
+
+	if (len < 5 || len - 5 + sizeof(".trace") > sizeof(path)) {
+		fprintf(out, "error: no trace path\n");
+		return;
+	}
+
+	memcpy(path, sock_path, len - 5);
+	memcpy(path + len - 5, ".trace", sizeof(".trace"));
+
+	n = dump_trace(path);
+	if (n < 0)
+		fprintf(out, "error: trace not written\n");
+	else
+		fprintf(out, "%d records %s\n", n, path);
+}
+
+static void query_workspaces(FILE* out)
+{
+	struct screen* s;
+
+	/* clients tagged with it, a client with several tags counts on each; shown counts the screens */
+	for (uint32_t i = 0; i < WS_COUNT; i++) {
+		int n = 0;
+		int shown = 0;
+
+		wl_list_for_each(s, &wm.screens, link) {
+			n += s->occ.count[i];
+			shown += (s->tags >> i) & 1;
+		}
+
+		fprintf(out, "%u clients=%d shown=%d\n", i + 1, n, shown);
+	}
+}
+
+static int set_flags(int fd)
+{
+	int fl = fcntl(fd, F_GETFL);
+
+	if (fl < 0 || fcntl(fd, F_SETFL, fl | O_NONBLOCK) < 0)
+		return -1;
+
+	return fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+/* a status line, to every subscriber */
+void ipc_publish(const char* buf, size_t len)
+{
+	struct ipc_client* ic;
+	struct ipc_client* tmp;
+
+	wl_list_for_each_safe(ic, tmp, &clients, link) {
+		if (ic->subscribed && !client_send(ic, buf, len))
+			client_close(ic);
+	}
+}
+
+bool ipc_subscribed(void)
+{
+	return subscribers > 0;
+}
+
+void ipc_finish(void)
+{
+	struct ipc_client* ic;
+	struct ipc_client* tmp;
+
+	if (listen_fd < 0)
+		return;
+
+	wl_list_for_each_safe(ic, tmp, &clients, link)
+		client_close(ic);
+
+	wl_event_source_remove(listen_src);
+	close(listen_fd);
+	unlink(sock_path);
+	listen_fd = -1;
+}
+
+void ipc_init(const char* display)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	const char* dir = getenv("XDG_RUNTIME_DIR");
+	int n;
+
+	wl_list_init(&clients);
+
+	if (!dir) {
+		log_warn("XDG_RUNTIME_DIR unset, no control socket");
+		return;
+	}
+
+	n = snprintf(sock_path, sizeof(sock_path), "%s/wsxwm-%s.sock", dir, display);
+	if (n < 0 || (size_t)n >= sizeof(sock_path)) {
+		log_warn("control socket path too long");
+		return;
+	}
+	memcpy(addr.sun_path, sock_path, (size_t)n + 1);
+
+	listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listen_fd < 0 || set_flags(listen_fd) < 0)
+		goto fail;
+
+	unlink(sock_path);
+	if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd, 16) < 0)
+		goto fail;
+
+	listen_src = wl_event_loop_add_fd(wm.ev_loop, listen_fd, WL_EVENT_READABLE, on_accept, NULL);
+	if (!listen_src)
+		goto fail;
+
+	setenv("WSXWM_SOCKET", sock_path, 1);
+	log_info("WSXWM_SOCKET=%s", sock_path);
+	return;
+
+fail:
+	log_warn("control socket %s unavailable", sock_path);
+	if (listen_fd >= 0)
+		close(listen_fd);
+	listen_fd = -1;
+}
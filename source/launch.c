@@ -0,0 +1,138 @@
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+
+#include <wayland-server.h>
+
+#include "launch.h"
+#include "log.h"
+#include "stats.h"
+#include "util.h"
+#include "wsxwm.h"
+
+/*
+ * children are started with posix_spawn, which avoids duplicating the
+ * compositor's page tables, and reaped from a SIGCHLD source on the loop.
+ * every pid we started stays in the list until it exits, so other code
+ * can map a pid back to the launch that created it.
+ */
+
+extern char** environ;
+
+static int on_sigchld(int sig, void* data);
+
+static struct wl_list children;
+static struct wl_event_source* sigchld_src = NULL;
+
+static int on_sigchld(int sig, void* data)
+{
+	struct child* ch;
+	pid_t pid;
+	int status;
+
+	(void)sig;
+	(void)data;
+
+	while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+		ch = launch_find(pid);
+		if (!ch)
+			continue;
+
+		if (ch->exited)
+			ch->exited(ch);
+		wl_list_remove(&ch->link);
+		free(ch);
+	}
+
+	return 0;
+}
+
+struct child* launch_find(pid_t pid)
+{
+	struct child* ch;
+
+	wl_list_for_each(ch, &children, link) {
+		if (ch->pid == pid)
+			return ch;
+	}
+
+	return NULL;
+}
+
+void launch_finish(void)
+{
+	struct child* ch;
+	struct child* tmp;
+
+	wl_list_for_each_safe(ch, tmp, &children, link) {
+		wl_list_remove(&ch->link);
+		free(ch);
+	}
+
+	if (sigchld_src) {
+		wl_event_source_remove(sigchld_src);
+		sigchld_src = NULL;
+	}
+}
+
+void launch_init(void)
+{
+	wl_list_init(&children);
+
+	sigchld_src = wl_event_loop_add_signal(wm.ev_loop, SIGCHLD, on_sigchld, NULL);
+	if (!sigchld_src)
+		log_warn("SIGCHLD source unavailable, children will not be reaped");
+}
+
+/* time is the triggering input event in ms, 0 if there was none */
+struct child* launch_spawn(char* const* argv, uint32_t time)
+{
+	static const int reset[] = { SIGCHLD, SIGINT, SIGPIPE, SIGQUIT, SIGTERM, SIGUSR1 };
+
+	posix_spawnattr_t attr;
+	sigset_t mask;
+	sigset_t def;
+	struct child* ch;
+	uint64_t t0 = stats_now();
+	pid_t pid;
+	int err;
+
+	ch = malloc(sizeof(*ch));
+	if (!ch)
+		return NULL;
+
+	/* the event loop blocks the signals it handles, do not pass that on */
+	sigemptyset(&mask);
+	sigemptyset(&def);
+	for (size_t i = 0; i < LENGTH(reset); i++)
+		sigaddset(&def, reset[i]);
+
+	posix_spawnattr_init(&attr);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+	posix_spawnattr_setsigmask(&attr, &mask);
+	posix_spawnattr_setsigdefault(&attr, &def);
+
+	err = posix_spawnp(&pid, argv[0], NULL, &attr, argv, environ);
+	posix_spawnattr_destroy(&attr);
+
+	if (err) {
+		log_warn("spawn %s: %s", argv[0], strerror(err));
+		free(ch);
+		return NULL;
+	}
+
+	ch->pid = pid;
+	ch->started = stats_now();
+	ch->data = NULL;
+	ch->exited = NULL;
+	wl_list_insert(&children, &ch->link);
+
+	hist_record(&stats[STAT_SPAWN], ch->started - t0);
+	if (time)
+		hist_record(&stats[STAT_SPAWN_INPUT], stats_input_age(time, ch->started));
+
+	return ch;
+}
@@ -0,0 +1,120 @@
+#include "layout.h"
+
+/*
+ * layouts are pure: they only read their parameters and write out[].
+ * swc draws borders outside of the geometry it is given, so outer gaps
+ * leave room for one border and gaps between windows for two.
+ */
+
+static void inner_area(const struct layout_params* p, struct swc_rectangle* r);
+static void split(uint32_t total, uint32_t gap, size_t n, size_t i, uint32_t* off, uint32_t* len);
+
+static void inner_area(const struct layout_params* p, struct swc_rectangle* r)
+{
+	int32_t out_gaps = p->gaps + p->border_width;
+
+	r->x = p->area.x + out_gaps;
+	r->y = p->area.y + out_gaps;
+	r->width  = p->area.width - (out_gaps * 2);
+	r->height = p->area.height - (out_gaps * 2);
+}
+
+/* i-th of n equal cells along total, the last one takes the remainder */
+static void split(uint32_t total, uint32_t gap, size_t n, size_t i, uint32_t* off, uint32_t* len)
+{
+	uint32_t cell = (total - gap * (uint32_t)(n - 1)) / (uint32_t)n;
+
+	*off = (uint32_t)i * (cell + gap);
+	*len = i + 1 == n ? total - *off : cell;
+}
+
+void layout_columns(const struct layout_params* p, size_t n, struct swc_rectangle* out)
+{
+	struct swc_rectangle a;
+	uint32_t in_gaps = p->gaps + (p->border_width * 2);
+	uint32_t off;
+
+	inner_area(p, &a);
+
+	for (size_t i = 0; i < n; i++) {
+		out[i] = a;
+		split(a.width, in_gaps, n, i, &off, &out[i].width);
+		out[i].x = a.x + (int32_t)off;
+	}
+}
+
+void layout_grid(const struct layout_params* p, size_t n, struct swc_rectangle* out)
+{
+	struct swc_rectangle a;
+	uint32_t in_gaps = p->gaps + (p->border_width * 2);
+	size_t cols = 1;
+	size_t rows;
+	uint32_t off;
+
+	if (n == 0)
+		return;
+
+	inner_area(p, &a);
+
+	while (cols * cols < n)
+		cols++;
+	rows = (n + cols - 1) / cols;
+
+	for (size_t i = 0; i < n; i++) {
+		size_t row = i / cols;
+		size_t col = i % cols;
+		/* the last row spreads its windows over the full width */
+		size_t in_row = row + 1 == rows ? n - row * cols : cols;
+
+		split(a.height, in_gaps, rows, row, &off, &out[i].height);
+		out[i].y = a.y + (int32_t)off;
+		split(a.width, in_gaps, in_row, col, &off, &out[i].width);
+		out[i].x = a.x + (int32_t)off;
+	}
+}
+
+void layout_monocle(const struct layout_params* p, size_t n, struct swc_rectangle* out)
+{
+	struct swc_rectangle a;
+
+	inner_area(p, &a);
+
+	for (size_t i = 0; i < n; i++)
+		out[i] = a;
+}
+
+void layout_tile(const struct layout_params* p, size_t n, struct swc_rectangle* out)
+{
+	struct swc_rectangle a;
+	uint32_t in_gaps = p->gaps + (p->border_width * 2);
+
+	if (n == 0)
+		return;
+
+	inner_area(p, &a);
+
+	/* one window, fullscreen it */
+	if (n == 1) {
+		out[0] = a;
+		return;
+	}
+
+	/* master */
+	out[0].x = a.x;
+	out[0].y = a.y;
+	out[0].width = p->master_width;
+	out[0].height = a.height;
+
+	/* stack */
+	uint32_t stackn = (uint32_t)n - 1;
+	uint32_t stack_height = (a.height - in_gaps * (stackn - 1)) / stackn;
+
+	for (size_t i = 1; i < n; i++) {
+		uint32_t idx = (uint32_t)i - 1;
+
+		out[i].x = a.x + p->master_width + in_gaps;
+		out[i].y = a.y + (idx * (stack_height + in_gaps));
+		out[i].width  = a.width - p->master_width - in_gaps;
+		out[i].height = stack_height;
+	}
+}
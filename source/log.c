@@ -0,0 +1,221 @@
+#include <errno.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <wayland-server.h>
+
+#include "log.h"
+#include "types.h"
+#include "wsxwm.h"
+
+/*
+ * records are formatted into a byte ring and written to stderr later, so
+ * logging costs no syscall on the compositor's path. if stderr can be
+ * polled (a pipe, a socket, a tty) the ring drains while it is writable,
+ * at most PIPE_BUF bytes at a time, so a slow reader cannot stall input.
+ * otherwise (a file) it drains from an idle source. a record that does not
+ * fit is dropped and counted, and a note of how many went missing goes out
+ * ahead of the next one that fits. log_flush() drains it synchronously.
+ * once the reader hangs up the ring is dropped, later records go to idle
+ * and are discarded by the first write that fails.
+ */
+
+enum {
+	LOG_RING = 16384,           /* power of two */
+	LOG_LINE = 512,
+};
+
+static void drain(size_t max);
+static bool note_missed(void);
+static int on_log_writable(int fd, uint32_t mask, void* data);
+static void on_log_idle(void* data);
+static bool push(const char* buf, size_t len);
+static void schedule(void);
+
+static const char* const prefix[] = {
+	[LOG_ERR]   = "wsxwm: error: ",
+	[LOG_WARN]  = "wsxwm: warning: ",
+	[LOG_INFO]  = "wsxwm: ",
+	[LOG_DEBUG] = "wsxwm: ",
+};
+
+static char ring[LOG_RING];
+static size_t head = 0;             /* free running, masked on use */
+static size_t tail = 0;
+static uint64_t missed = 0;         /* dropped since the last note */
+static struct wl_event_loop* log_loop = NULL;
+static struct wl_event_source* out_src = NULL;
+static struct wl_event_source* idle = NULL;
+static bool armed = false;
+
+/* writes up to max bytes of the ring, a failed write discards the rest */
+static void drain(size_t max)
+{
+	while (tail != head && max > 0) {
+		size_t off = tail & (LOG_RING - 1);
+		size_t len = head - tail;
+		ssize_t n;
+
+		if (len > LOG_RING - off)
+			len = LOG_RING - off;
+		if (len > max)
+			len = max;
+
+		n = write(STDERR_FILENO, ring + off, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			tail = head;
+			break;
+		}
+		tail += (size_t)n;
+		max -= (size_t)n;
+	}
+}
+
+/* queues how many records went missing, false if that does not fit either */
+static bool note_missed(void)
+{
+	char buf[LOG_LINE];
+	int n;
+
+	if (!missed)
+		return true;
+
+	n = snprintf(buf, sizeof(buf), "%s%llu log records dropped\n",
+		prefix[LOG_WARN], (unsigned long long)missed);
+	if (n < 0 || !push(buf, (size_t)n))
+		return false;
+
+	missed = 0;
+	return true;
+}
+
+static int on_log_writable(int fd, uint32_t mask, void* data)
+{
+	(void)fd;
+	(void)data;
+
+	/* the reader is gone, what is queued has nowhere to go */
+	if (mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR)) {
+		wl_event_source_remove(out_src);
+		out_src = NULL;
+		armed = false;
+		tail = head;
+		return 0;
+	}
+
+	drain(PIPE_BUF);
+	if (tail == head) {
+		wl_event_source_fd_update(out_src, 0);
+		armed = false;
+	}
+	return 0;
+}
+
+static void on_log_idle(void* data)
+{
+	(void)data;
+
+	idle = NULL;
+	drain(LOG_RING);
+}
+
+static bool push(const char* buf, size_t len)
+{
+	size_t off = head & (LOG_RING - 1);
+	size_t n = len < LOG_RING - off ? len : LOG_RING - off;
+
+	if (LOG_RING - (head - tail) < len)
+		return false;
+
+	memcpy(ring + off, buf, n);
+	memcpy(ring, buf + n, len - n);
+	head += len;
+	return true;
+}
+
+static void schedule(void)
+{
+	if (!log_loop) {
+		drain(LOG_RING);
+		return;
+	}
+
+	if (out_src) {
+		if (!armed)
+			wl_event_source_fd_update(out_src, WL_EVENT_WRITABLE);
+		armed = true;
+	}
+	else if (!idle) {
+		idle = wl_event_loop_add_idle(log_loop, on_log_idle, NULL);
+		if (!idle)
+			drain(LOG_RING);
+	}
+}
+
+void log_emit(int level, const char* fmt, ...)
+{
+	char buf[LOG_LINE];
+	va_list ap;
+	int n;
+	int len;
+
+	len = snprintf(buf, sizeof(buf), "%s", prefix[level]);
+	va_start(ap, fmt);
+	n = vsnprintf(buf + len, sizeof(buf) - (size_t)len, fmt, ap);
+	va_end(ap);
+	if (n < 0)
+		return;
+
+	/* a long record is cut short, it still ends its line */
+	len += n;
+	if ((size_t)len > sizeof(buf) - 2)
+		len = sizeof(buf) - 2;
+	if (len > 0 && buf[len - 1] == '\n')
+		len--;
+	buf[len++] = '\n';
+
+	if (!note_missed() || !push(buf, (size_t)len)) {
+		missed++;
+		wm.count.log_dropped++;
+		return;
+	}
+
+	schedule();
+}
+
+void log_finish(void)
+{
+	log_flush();
+
+	if (out_src)
+		wl_event_source_remove(out_src);
+	if (idle)
+		wl_event_source_remove(idle);
+	out_src = NULL;
+	idle = NULL;
+	armed = false;
+	log_loop = NULL;
+}
+
+void log_flush(void)
+{
+	drain(LOG_RING);
+	note_missed();
+	drain(LOG_RING);
+}
+
+void log_init(struct wl_event_loop* loop)
+{
+	log_loop = loop;
+
+	/* epoll refuses regular files, those drain from idle */
+	out_src = wl_event_loop_add_fd(loop, STDERR_FILENO, 0, on_log_writable, NULL);
+	armed = false;
+	if (tail != head)
+		schedule();
+}
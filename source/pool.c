@@ -0,0 +1,122 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+
+/*
+ * fixed size objects in cache line aligned slabs. a slot's generation is
+ * bumped every time it is freed, so a handle taken before the free no
+ * longer resolves. slabs are only ever added, freed slots are reused
+ * through an intrusive free list.
+ */
+
+enum {
+	CACHE_LINE = 64,
+	FREE_END   = UINT32_MAX,
+};
+
+static bool grow(struct pool* p);
+static void* slot(const struct pool* p, uint32_t idx);
+
+static bool grow(struct pool* p)
+{
+	size_t n = p->nslabs * p->per_slab;
+	void** slabs;
+	uint32_t* gens;
+	void* slab;
+
+	if (n + p->per_slab > FREE_END)
+		return false;
+
+	slabs = realloc(p->slabs, (p->nslabs + 1) * sizeof(*slabs));
+	if (!slabs)
+		return false;
+	p->slabs = slabs;
+
+	gens = realloc(p->gens, (n + p->per_slab) * sizeof(*gens));
+	if (!gens)
+		return false;
+	p->gens = gens;
+
+	if (posix_memalign(&slab, CACHE_LINE, p->per_slab * p->size) != 0)
+		return false;
+
+	p->slabs[p->nslabs++] = slab;
+
+	/* thread the new slots onto the free list in index order */
+	for (size_t i = p->per_slab; i-- > 0;) {
+		uint32_t idx = (uint32_t)(n + i);
+
+		p->gens[idx] = 1;
+		memcpy(slot(p, idx), &p->free, sizeof(p->free));
+		p->free = idx;
+	}
+
+	return true;
+}
+
+static void* slot(const struct pool* p, uint32_t idx)
+{
+	return (char*)p->slabs[idx / p->per_slab] + (idx % p->per_slab) * p->size;
+}
+
+void* pool_alloc(struct pool* p, struct handle* h)
+{
+	void* obj;
+
+	if (p->free == FREE_END && !grow(p))
+		return NULL;
+
+	obj = slot(p, p->free);
+	h->idx = p->free;
+	h->gen = p->gens[p->free];
+	memcpy(&p->free, obj, sizeof(p->free));
+
+	memset(obj, 0, p->size);
+	p->used++;
+
+	return obj;
+}
+
+void pool_finish(struct pool* p)
+{
+	for (size_t i = 0; i < p->nslabs; i++)
+		free(p->slabs[i]);
+
+	free(p->slabs);
+	free(p->gens);
+	memset(p, 0, sizeof(*p));
+	p->free = FREE_END;
+}
+
+void pool_free(struct pool* p, struct handle h)
+{
+	void* obj = pool_get(p, h);
+
+	if (!obj)
+		return;
+
+	/* generation 0 is reserved for HANDLE_NONE */
+	if (++p->gens[h.idx] == 0)
+		p->gens[h.idx] = 1;
+
+	memcpy(obj, &p->free, sizeof(p->free));
+	p->free = h.idx;
+	p->used--;
+}
+
+void* pool_get(const struct pool* p, struct handle h)
+{
+	if (h.gen == 0 || h.idx >= p->nslabs * p->per_slab || p->gens[h.idx] != h.gen)
+		return NULL;
+
+	return slot(p, h.idx);
+}
+
+void pool_init(struct pool* p, size_t size, size_t per_slab)
+{
+	memset(p, 0, sizeof(*p));
+	p->size = (size + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1);
+	p->per_slab = per_slab;
+	p->free = FREE_END;
+}
@@ -0,0 +1,132 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "rules.h"
+#include "util.h"
+
+/*
+ * rules are hashed on app_id, or on title for rules without one, into
+ * open addressed tables at most half full. rules sharing a key are
+ * chained in config order, so a lookup touches one chain per key and the
+ * first rule in config.h order still wins. indices are stored plus one,
+ * zero marks an empty slot or the end of a chain.
+ */
+
+static uint32_t hash(const char* s);
+static uint32_t* lookup(const struct rule_index* ri, uint32_t* slots, const char* key, bool by_title);
+
+/* fnv-1a */
+static uint32_t hash(const char* s)
+{
+	uint32_t h = 2166136261u;
+
+	while (*s) {
+		h ^= (uint8_t)*s++;
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+/* the slot holding key, or the empty one it would go in */
+static uint32_t* lookup(const struct rule_index* ri, uint32_t* slots, const char* key, bool by_title)
+{
+	size_t mask = ri->cap - 1;
+	const struct rule* r;
+
+	for (size_t i = hash(key) & mask;; i = (i + 1) & mask) {
+		if (!slots[i])
+			return &slots[i];
+
+		r = &ri->rules[slots[i] - 1];
+		if (strcmp(by_title ? r->title : r->app_id, key) == 0)
+			return &slots[i];
+	}
+}
+
+void rules_finish(struct rule_index* ri)
+{
+	free(ri->app_slots);
+	free(ri->title_slots);
+	free(ri->next);
+	*ri = (struct rule_index){ 0 };
+}
+
+void rules_init(struct rule_index* ri, const struct rule* rules, size_t n)
+{
+	uint32_t* head;
+
+	*ri = (struct rule_index){ 0 };
+	if (n == 0)
+		return;
+
+	ri->cap = 8;
+	while (ri->cap < n * 2)
+		ri->cap *= 2;
+
+	ri->app_slots = calloc(ri->cap, sizeof(*ri->app_slots));
+	ri->title_slots = calloc(ri->cap, sizeof(*ri->title_slots));
+	ri->next = calloc(n, sizeof(*ri->next));
+	if (!ri->app_slots || !ri->title_slots || !ri->next) {
+		log_warn("rule index unavailable, window rules are off");
+		rules_finish(ri);
+		return;
+	}
+
+	ri->rules = rules;
+	ri->n = n;
+
+	/* pushed back to front, so each chain ends up in config order */
+	for (size_t i = n; i-- > 0;) {
+		if (rules[i].app_id)
+			head = lookup(ri, ri->app_slots, rules[i].app_id, false);
+		else if (rules[i].title)
+			head = lookup(ri, ri->title_slots, rules[i].title, true);
+		else
+			head = &ri->any;
+		if (rules[i].app_id)
+			ri->first_app = (uint32_t)i + 1;
+
+		ri->next[i] = *head;
+		*head = (uint32_t)i + 1;
+	}
+}
+
+/* a window matching r (NULL for none) would match an earlier rule once it has an app_id */
+bool rules_await_app_id(const struct rule_index* ri, const struct rule* r)
+{
+	return ri->first_app && (!r || ri->first_app <= (uint32_t)(r - ri->rules));
+}
+
+const struct rule* rules_match(const struct rule_index* ri, const char* app_id, const char* title)
+{
+	const struct rule* r;
+	uint32_t best = 0;
+	uint32_t v;
+
+	if (!ri->rules)
+		return NULL;
+
+	if (app_id) {
+		for (v = *lookup(ri, ri->app_slots, app_id, false); v; v = ri->next[v - 1]) {
+			r = &ri->rules[v - 1];
+			if (!r->title || (title && strcmp(r->title, title) == 0)) {
+				best = v;
+				break;
+			}
+		}
+	}
+
+	/* title only and catch-all chains match on their first entry */
+	if (title) {
+		v = *lookup(ri, ri->title_slots, title, true);
+		if (v && (!best || v < best))
+			best = v;
+	}
+
+	if (ri->any && (!best || ri->any < best))
+		best = ri->any;
+
+	return best ? &ri->rules[best - 1] : NULL;
+}
@@ -0,0 +1,230 @@
+#include <stdlib.h>
+
+#include "pool.h"
+#include "spatial.h"
+#include "util.h"
+#include "wsxwm.h"
+
+/*
+ * geometry queries over what a screen shows, for directional focus, swap
+ * and edge snapping. swc does not report where a window is, so this goes
+ * by the geometry wsxwm last sent, a client whose geometry is not known
+ * (a float after a pointer move) is left out. the index is rebuilt by the
+ * first query after wm.geom_seq moved, a neighbour is a scan of a packed
+ * array and a snap a binary search over the sorted edges
+ */
+
+static int cmp_edge(const void* a, const void* b);
+static bool grow(struct spatial* sp, size_t n);
+static void rebuild(struct screen* s);
+static bool usable(const struct screen* s, struct handle id);
+
+static int cmp_edge(const void* a, const void* b)
+{
+	int32_t x = *(const int32_t*)a;
+	int32_t y = *(const int32_t*)b;
+
+	return (x > y) - (x < y);
+}
+
+static bool grow(struct spatial* sp, size_t n)
+{
+	struct swc_rectangle* rects;
+	struct handle* ids;
+	int32_t* xs;
+	int32_t* ys;
+	size_t cap = sp->cap ? sp->cap : 16;
+
+	if (n <= sp->cap)
+		return true;
+	while (cap < n)
+		cap *= 2;
+
+	rects = realloc(sp->rects, cap * sizeof(*rects));
+	if (rects)
+		sp->rects = rects;
+	ids = realloc(sp->ids, cap * sizeof(*ids));
+	if (ids)
+		sp->ids = ids;
+	xs = realloc(sp->xs, (2 * cap + 2) * sizeof(*xs));
+	if (xs)
+		sp->xs = xs;
+	ys = realloc(sp->ys, (2 * cap + 2) * sizeof(*ys));
+	if (ys)
+		sp->ys = ys;
+	if (!rects || !ids || !xs || !ys)
+		return false;
+
+	sp->cap = cap;
+	return true;
+}
+
+static void rebuild(struct screen* s)
+{
+	struct spatial* sp = &s->index;
+	const struct swc_rectangle* u = &s->scr->usable_geometry;
+	struct client* c;
+	size_t n = 0;
+
+	for (c = first_tiled(s); c; c = next_tiled(s, c))
+		n++;
+	for (c = first_float(s); c; c = next_float(s, c))
+		n++;
+
+	sp->n = 0;
+	sp->seq = wm.geom_seq;
+	if (!grow(sp, n)) {
+		sp->seq = 0;
+		return;
+	}
+
+	for (c = first_tiled(s); c; c = next_tiled(s, c)) {
+		if (c->sent.geom_valid && !c->covered) {
+			sp->rects[sp->n] = c->sent.geom;
+			sp->ids[sp->n++] = c->id;
+		}
+	}
+	for (c = first_float(s); c; c = next_float(s, c)) {
+		if (c->sent.geom_valid) {
+			sp->rects[sp->n] = c->sent.geom;
+			sp->ids[sp->n++] = c->id;
+		}
+	}
+
+	for (size_t i = 0; i < sp->n; i++) {
+		const struct swc_rectangle* r = &sp->rects[i];
+
+		sp->xs[2 * i] = r->x;
+		sp->xs[2 * i + 1] = r->x + (int32_t)r->width;
+		sp->ys[2 * i] = r->y;
+		sp->ys[2 * i + 1] = r->y + (int32_t)r->height;
+	}
+	sp->xs[2 * sp->n] = u->x;
+	sp->xs[2 * sp->n + 1] = u->x + (int32_t)u->width;
+	sp->ys[2 * sp->n] = u->y;
+	sp->ys[2 * sp->n + 1] = u->y + (int32_t)u->height;
+
+	qsort(sp->xs, 2 * sp->n + 2, sizeof(*sp->xs), cmp_edge);
+	qsort(sp->ys, 2 * sp->n + 2, sizeof(*sp->ys), cmp_edge);
+}
+
+/* an entry still names a client shown on s, whatever moved since */
+static bool usable(const struct screen* s, struct handle id)
+{
+	struct client* c = client_at(id);
+
+	return c && HANDLE_EQ(c->scr, s->id) && client_visible(c) && !c->covered && c->sent.geom_valid;
+}
+
+void spatial_finish(struct spatial* sp)
+{
+	free(sp->rects);
+	free(sp->ids);
+	free(sp->xs);
+	free(sp->ys);
+	*sp = (struct spatial){ 0 };
+}
+
+/*
+ * the client next to from in dir: its centre must lie beyond from's, one
+ * overlapping from across dir wins over one that does not, then the
+ * smaller gap, then the smaller offset of the centres across dir
+ */
+struct client* spatial_neighbour(struct screen* s, const struct client* self,
+	const struct swc_rectangle* from, uint32_t dir)
+{
+	struct spatial* sp = &s->index;
+	bool horiz = dir == DIR_LEFT || dir == DIR_RIGHT;
+	bool fwd = dir == DIR_RIGHT || dir == DIR_DOWN;
+	int64_t fa = horiz ? from->x : from->y;                 /* along dir */
+	int64_t fl = horiz ? from->width : from->height;
+	int64_t fc = horiz ? from->y : from->x;                 /* across */
+	int64_t fw = horiz ? from->height : from->width;
+	struct client* best = NULL;
+	int64_t best_key[3] = { 0 };
+
+	if (sp->seq != wm.geom_seq)
+		rebuild(s);
+
+	for (size_t i = 0; i < sp->n; i++) {
+		const struct swc_rectangle* r = &sp->rects[i];
+		int64_t ra = horiz ? r->x : r->y;
+		int64_t rl = horiz ? r->width : r->height;
+		int64_t rc = horiz ? r->y : r->x;
+		int64_t rw = horiz ? r->height : r->width;
+		int64_t key[3];
+
+		if (self && HANDLE_EQ(sp->ids[i], self->id))
+			continue;
+
+		/* doubled centres keep it in integers */
+		if (fwd ? 2 * ra + rl <= 2 * fa + fl : 2 * ra + rl >= 2 * fa + fl)
+			continue;
+
+		key[0] = (rc < fc + fw && fc < rc + rw) ? 0 : 1;
+		key[1] = fwd ? ra - (fa + fl) : fa - (ra + rl);
+		if (key[1] < 0)
+			key[1] = 0;
+		key[2] = llabs((2 * rc + rw) - (2 * fc + fw));
+
+		if (best && (key[0] > best_key[0]
+			|| (key[0] == best_key[0] && (key[1] > best_key[1]
+			|| (key[1] == best_key[1] && key[2] >= best_key[2])))))
+			continue;
+
+		if (!usable(s, sp->ids[i]))
+			continue;
+
+		best = client_at(sp->ids[i]);
+		best_key[0] = key[0];
+		best_key[1] = key[1];
+		best_key[2] = key[2];
+	}
+
+	return best;
+}
+
+/*
+ * the first window or usable area edge more than slack past edge in dir,
+ * on the axis of dir. false if there is none
+ */
+bool spatial_snap(struct screen* s, int32_t edge, int32_t slack, uint32_t dir, int32_t* out)
+{
+	struct spatial* sp = &s->index;
+	bool horiz = dir == DIR_LEFT || dir == DIR_RIGHT;
+	bool fwd = dir == DIR_RIGHT || dir == DIR_DOWN;
+	const int32_t* e;
+	size_t lo = 0;
+	size_t hi;
+
+	if (sp->seq != wm.geom_seq)
+		rebuild(s);
+	if (!sp->seq)
+		return false;
+
+	e = horiz ? sp->xs : sp->ys;
+	hi = 2 * sp->n + 2;
+	edge += fwd ? slack : -slack;
+
+	/* lo ends at the first edge above edge, or at or above it going back */
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (fwd ? e[mid] <= edge : e[mid] < edge)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (fwd) {
+		if (lo == 2 * sp->n + 2)
+			return false;
+		*out = e[lo];
+	}
+	else {
+		if (lo == 0)
+			return false;
+		*out = e[lo - 1];
+	}
+	return true;
+}
@@ -0,0 +1,121 @@
+#include <time.h>
+
+#include "stats.h"
+
+static uint32_t bucket_of(uint64_t ns);
+static uint64_t bucket_top(uint32_t idx);
+
+struct hist stats[STAT_COUNT] = {
+	[STAT_TILE]            = { .name = "tile" },
+	[STAT_FOCUS]           = { .name = "focus" },
+	[STAT_NEW_WINDOW]      = { .name = "new_window" },
+	[STAT_WIN_DESTROY]     = { .name = "on_win_destroy" },
+	[STAT_WIN_ENTERED]     = { .name = "on_win_entered" },
+	[STAT_NEW_SCREEN]      = { .name = "new_screen" },
+	[STAT_SCREEN_GEOMETRY] = { .name = "on_screen_usable_geometry_changed" },
+	[STAT_SPAWN]           = { .name = "spawn (posix_spawn to exec)" },
+	[STAT_SPAWN_INPUT]     = { .name = "spawn (input to exec)" },
+};
+
+static uint32_t bucket_of(uint64_t ns)
+{
+	uint32_t msb;
+	uint32_t idx;
+
+	if (ns < 4)
+		return (uint32_t)ns;
+
+	msb = 63 - (uint32_t)__builtin_clzll(ns);
+	idx = (msb - 1) * 4 + (uint32_t)((ns >> (msb - 2)) & 3);
+
+	return idx < HIST_BUCKETS ? idx : HIST_BUCKETS - 1;
+}
+
+static uint64_t bucket_top(uint32_t idx)
+{
+	uint32_t msb;
+
+	if (idx < 4)
+		return idx;
+
+	msb = idx / 4 + 1;
+	return ((uint64_t)(4 + idx % 4) << (msb - 2)) + ((uint64_t)1 << (msb - 2)) - 1;
+}
+
+void hist_dump(const struct hist* h, FILE* fd)
+{
+	if (!h->count)
+		return;
+
+	fprintf(fd, "%-36s %10llu %10.1f %10.1f %10.1f %10.1f\n",
+		h->name, (unsigned long long)h->count,
+		(double)h->sum / (double)h->count / 1000.0,
+		(double)hist_percentile(h, 0.50) / 1000.0,
+		(double)hist_percentile(h, 0.99) / 1000.0,
+		(double)h->max / 1000.0);
+}
+
+void hist_header(FILE* fd, const char* what)
+{
+	fprintf(fd, "%-36s %10s %10s %10s %10s %10s\n",
+		what, "count", "avg(us)", "p50(us)", "p99(us)", "max(us)");
+}
+
+/* upper bound of the bucket holding the p-th sample, clamped to max */
+uint64_t hist_percentile(const struct hist* h, double p)
+{
+	uint64_t rank;
+	uint64_t seen = 0;
+
+	if (!h->count)
+		return 0;
+
+	rank = (uint64_t)((double)h->count * p);
+	if (rank < 1)
+		rank = 1;
+
+	for (uint32_t i = 0; i < HIST_BUCKETS; i++) {
+		seen += h->buckets[i];
+		if (seen >= rank) {
+			uint64_t top = bucket_top(i);
+			return top < h->max ? top : h->max;
+		}
+	}
+
+	return h->max;
+}
+
+void hist_record(struct hist* h, uint64_t ns)
+{
+	h->count++;
+	h->sum += ns;
+	if (ns > h->max)
+		h->max = ns;
+	h->buckets[bucket_of(ns)]++;
+}
+
+void stats_dump(FILE* fd)
+{
+	hist_header(fd, "handler");
+
+	for (size_t i = 0; i < STAT_COUNT; i++)
+		hist_dump(&stats[i], fd);
+}
+
+/*
+ * ns from an input event, stamped in ms on the same clock, to now. the
+ * stamp wraps after 49 days, the difference is taken in its width. it
+ * counts from the start of the event's ms, so it is high by up to 1ms
+ */
+uint64_t stats_input_age(uint32_t time, uint64_t now)
+{
+	return (uint64_t)(uint32_t)((uint32_t)(now / 1000000) - time) * 1000000 + now % 1000000;
+}
+
+uint64_t stats_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <wayland-server.h>
+
+#include "ipc.h"
+#include "status.h"
+#include "types.h"
+#include "util.h"
+#include "wsxwm.h"
+
+/*
+ * the status line subscribers of the control socket get. anything that
+ * may change it calls status_touch(), which only queues an idle source,
+ * so a burst of changes within one loop iteration is formatted once.
+ * the line is compared with the last one published and dropped if it is
+ * the same, so a subscriber is only woken for a change it can show.
+ * nothing in this tree reads it yet; it goes over the control socket
+ * because that is already on the loop and a reader can block in read(),
+ * where a shared memory page would need its own file and a polling reader.
+ */
+
+static void on_status_idle(void* data);
+static void put_text(FILE* out, const char* text);
+
+static struct wl_event_source* idle = NULL;
+static char* last = NULL;
+static size_t last_len = 0;
+
+static void on_status_idle(void* data)
+{
+	char* buf = NULL;
+	size_t len = 0;
+	FILE* out;
+
+	(void)data;
+
+	idle = NULL;
+	if (!ipc_subscribed())
+		return;
+
+	out = open_memstream(&buf, &len);
+	if (!out)
+		return;
+	status_write(out);
+	fclose(out);
+
+	if (last && len == last_len && memcmp(buf, last, len) == 0) {
+		wm.count.status_elided++;
+		free(buf);
+		return;
+	}
+
+	free(last);
+	last = buf;
+	last_len = len;
+	wm.count.status_sent++;
+	ipc_publish(buf, len);
+}
+
+/* a newline in a title must not end the line early */
+static void put_text(FILE* out, const char* text)
+{
+	for (; text && *text; text++)
+		fputc(*text == '\n' || *text == '\r' ? ' ' : *text, out);
+}
+
+void status_finish(void)
+{
+	if (idle)
+		wl_event_source_remove(idle);
+	idle = NULL;
+	free(last);
+	last = NULL;
+	last_len = 0;
+}
+
+void status_touch(void)
+{
+	/* nobody saw this change, the next subscriber starts from scratch */
+	if (!ipc_subscribed()) {
+		free(last);
+		last = NULL;
+		last_len = 0;
+		return;
+	}
+	if (idle)
+		return;
+
+	idle = wl_event_loop_add_idle(wm.ev_loop, on_status_idle, NULL);
+}
+
+/*
+ * one line: a screen=workspace,tags,occupied,selected field per screen in
+ * the order they appeared, then the focused client. title is last, it
+ * may contain spaces
+ */
+void status_write(FILE* out)
+{
+	struct client* c = client_at(wm.sel_client);
+	struct screen* s;
+
+	wl_list_for_each_reverse(s, &wm.screens, link) {
+		fprintf(out, "screen=%u,%#x,%#x,%d ", s->sel_ws, s->tags, s->occ.mask,
+			s == screen_at(wm.sel_screen));
+	}
+
+	if (!c) {
+		fprintf(out, "focused=0\n");
+		return;
+	}
+
+	fprintf(out, "focused=1 floating=%d fullscreen=%d app_id=", c->floating, c->fullscreen);
+	put_text(out, c->win->app_id);
+	fprintf(out, " title=");
+	put_text(out, c->win->title);
+	fputc('\n', out);
+}
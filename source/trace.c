@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "stats.h"
+#include "trace.h"
+#include "util.h"
+
+/*
+ * every input the wm reacts to goes into a fixed ring of fixed size
+ * records, nothing is written out until trace_dump() is asked for it.
+ * recording is a store and an increment, cheap enough to leave on.
+ */
+
+static void push(const struct trace_rec* r);
+
+const char* trace_names[TRACE_TYPES] = {
+	[TRACE_NEW_SCREEN]      = "new_screen",
+	[TRACE_SCREEN_DESTROY]  = "screen_destroy",
+	[TRACE_SCREEN_GEOMETRY] = "screen_geometry",
+	[TRACE_SCREEN_USABLE]   = "screen_usable",
+	[TRACE_SCREEN_ENTERED]  = "screen_entered",
+	[TRACE_NEW_WINDOW]      = "new_window",
+	[TRACE_WIN_DESTROY]     = "win_destroy",
+	[TRACE_WIN_ENTERED]     = "win_entered",
+	[TRACE_BIND]            = "bind",
+	[TRACE_ACTION]          = "action",
+	[TRACE_WIN_APP_ID]      = "win_app_id",
+};
+
+static struct trace_rec* ring = NULL;
+static size_t ring_cap = 0;
+static uint64_t total = 0;
+static uint64_t start = 0;
+
+static void push(const struct trace_rec* r)
+{
+	if (!ring)
+		return;
+
+	ring[total % ring_cap] = *r;
+	ring[total % ring_cap].t = stats_now() - start;
+	total++;
+}
+
+int trace_dump(const char* path, uint32_t nbinds, uint32_t nactions, uint32_t nrules)
+{
+	struct trace_header h;
+	uint64_t first;
+	FILE* fd;
+
+	if (!ring)
+		return -1;
+
+	fd = fopen(path, "wb");
+	if (!fd)
+		return -1;
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+	h.version = TRACE_VERSION;
+	h.rec_size = sizeof(struct trace_rec);
+	h.nbinds = nbinds;
+	h.nactions = nactions;
+	h.nrules = nrules;
+	h.count = total < ring_cap ? total : ring_cap;
+	h.dropped = total - h.count;
+
+	/* oldest first, the ring may have wrapped */
+	first = h.dropped;
+	fwrite(&h, sizeof(h), 1, fd);
+	for (uint64_t i = first; i < total; i++)
+		fwrite(&ring[i % ring_cap], sizeof(*ring), 1, fd);
+
+	if (fclose(fd) != 0)
+		return -1;
+
+	return (int)h.count;
+}
+
+void trace_finish(void)
+{
+	free(ring);
+	ring = NULL;
+	ring_cap = 0;
+	total = 0;
+}
+
+void trace_init(size_t cap)
+{
+	start = stats_now();
+	if (cap == 0)
+		return;
+
+	ring = calloc(cap, sizeof(*ring));
+	if (!ring) {
+		log_warn("trace ring of %zu records unavailable", cap);
+		return;
+	}
+	ring_cap = cap;
+}
+
+void trace_input(uint8_t type, uint16_t index, uint32_t time, uint32_t value, uint32_t state, int32_t arg)
+{
+	struct trace_rec r = { .type = type, .index = index };
+
+	r.u.input.time = time;
+	r.u.input.value = value;
+	r.u.input.state = state;
+	r.u.input.arg = arg;
+	push(&r);
+}
+
+void trace_screen(uint8_t type, const struct swc_screen* scr, const struct swc_rectangle* geom, uint16_t index)
+{
+	struct trace_rec r = { .type = type, .index = index, .obj = (uint64_t)(uintptr_t)scr };
+
+	if (geom)
+		r.u.geom = *geom;
+	push(&r);
+}
+
+void trace_window(uint8_t type, const struct swc_window* win, uint16_t index)
+{
+	struct trace_rec r = { .type = type, .index = index, .obj = (uint64_t)(uintptr_t)win };
+
+	if (win->app_id)
+		r.flags |= TRACE_HAS_APP_ID;
+
+	push(&r);
+}
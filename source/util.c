@@ -2,13 +2,68 @@
 
 #include <swc.h>
 
+#include "log.h"
+#include "pool.h"
 #include "util.h"
 #include "wsxwm.h"
 
+static bool shown(const struct client* c, const struct client* fs, uint32_t tags);
+static struct client* step(struct screen* s, struct client* c, size_t head, size_t link, bool fwd);
+
+/* c is on a screen showing tags whose fullscreen client is fs */
+static bool shown(const struct client* c, const struct client* fs, uint32_t tags)
+{
+	return (c->tags & tags) && (!fs || fs == c || !(fs->tags & tags) || HANDLE_EQ(c->over, fs->id));
+}
+
+/*
+ * a client sits in the lists of its lowest tag only. walking the clients
+ * shown on a screen visits the lists of the shown tags, plus those holding
+ * a client with several tags, in tag order and skips what is not shown
+ */
+static struct client* step(struct screen* s, struct client* c, size_t head, size_t link, bool fwd)
+{
+	uint32_t lists;
+	uint32_t ws;
+	struct wl_list* h;
+	struct wl_list* l = NULL;
+
+	if (!s)
+		return NULL;
+
+	lists = screen_lists(s, s->tags);
+	ws = fwd ? 0 : WS_COUNT + 1;
+	if (c) {
+		ws = c->ws;
+		l = (struct wl_list*)((char*)c + link);
+	}
+
+	for (;;) {
+		if (l) {
+			h = (struct wl_list*)((char*)&s->ws[ws - 1] + head);
+			for (l = fwd ? l->next : l->prev; l != h; l = fwd ? l->next : l->prev) {
+				c = (struct client*)((char*)l - link);
+				if (shown(c, client_at(s->fs), s->tags))
+					return c;
+			}
+		}
+
+		do
+			ws = fwd ? ws + 1 : ws - 1;
+		while (ws >= 1 && ws <= WS_COUNT && !(lists & TAG(ws)));
+		if (ws < 1 || ws > WS_COUNT)
+			return NULL;
+
+		l = (struct wl_list*)((char*)&s->ws[ws - 1] + head);
+	}
+}
+
 void die(int ret, const char* fmt, ...)
 {
 	va_list ap;
 
+	/* what was logged before it comes first */
+	log_flush();
 	fprintf(stderr, "wsxwm: ");
 
 	va_start(ap, fmt);
@@ -21,76 +76,359 @@ void die(int ret, const char* fmt, ...)
 	exit(ret);
 }
 
-struct client* first_float(struct screen* s)
+void attach(struct client* c)
 {
-	struct client* c;
+	struct workspace* w = workspace_of(screen_at(c->scr), c->ws);
 
-	wl_list_for_each(c, &wm.floating, float_link) {
-		if (is_float(c, s))
-			return c;
+	if (!w) {
+		wl_list_init(&c->tiled_link);
+		wl_list_init(&c->float_link);
+		wl_list_init(&c->stack_link);
+		return;
 	}
 
-	return NULL;
+	occupancy_update(occupancy_of(screen_at(c->scr)), c->tags, c->ws, 1);
+	wm.geom_seq++;
+
+	/* new clients go to the head, i.e. become master or topmost */
+	if (c->floating) {
+		wl_list_insert(&w->floating, &c->float_link);
+		wl_list_insert(&w->stack, &c->stack_link);
+		wl_list_init(&c->tiled_link);
+	}
+	else {
+		wl_list_insert(&w->tiled, &c->tiled_link);
+		wl_list_init(&c->float_link);
+		wl_list_init(&c->stack_link);
+	}
 }
 
-struct client* first_tiled(struct screen* s)
+struct client* client_at(struct handle h)
 {
-	struct client* c;
+	return pool_get(&wm.client_pool, h);
+}
+
+void client_raise(struct client* c)
+{
+	struct workspace* w = workspace_of(screen_at(c->scr), c->ws);
 
-	wl_list_for_each(c, &wm.tiled, tiled_link) {
-		if (is_tiled(c, s))
-			return c;
+	if (!w || !c->floating || c->fullscreen)
+		return;
+
+	/* a shown workspace is always stacked in list order */
+	if (w->stack.next == &c->stack_link) {
+		wm.count.restack_elided++;
+		return;
 	}
 
-	return NULL;
+	wl_list_remove(&c->stack_link);
+	wl_list_insert(&w->stack, &c->stack_link);
+
+	/* hidden workspaces are put in order by workspace_restack() */
+	if (!client_visible(c))
+		return;
+
+	client_set_mode(c, MODE_STACKED, true);
+	wm.count.restack_sent++;
+}
+
+/* swc_window_hide/show for what tags and fullscreen decide, see client_visible() */
+void client_hide(struct client* c)
+{
+	/* already hidden, the layout pass shows it again if it has to */
+	if (!c->covered)
+		swc_window_hide(c->win);
+}
+
+void client_show(struct client* c)
+{
+	if (!c->covered)
+		swc_window_show(c->win);
+}
+
+bool client_visible(const struct client* c)
+{
+	struct screen* s = screen_at(c->scr);
+
+	return s && shown(c, client_at(s->fs), s->tags);
+}
+
+void client_set_border(struct client* c, uint32_t col, uint32_t width)
+{
+	struct shadow* sh = &c->sent;
+
+	if (sh->border_valid && sh->border_col == col && sh->border_width == width) {
+		wm.count.border_elided++;
+		return;
+	}
+
+	swc_window_set_border(c->win, col, width, 0, 0);
+	sh->border_col = col;
+	sh->border_width = width;
+	sh->border_valid = true;
+	wm.count.border_sent++;
+}
+
+/* swc sizes the window to scr, the geometry shadow follows */
+void client_set_fullscreen(struct client* c, struct swc_screen* scr)
+{
+	struct shadow* sh = &c->sent;
+	const struct swc_rectangle* g = &scr->geometry;
+
+	if (sh->mode == MODE_FULLSCREEN && sh->geom_valid
+		&& sh->geom.x == g->x && sh->geom.y == g->y
+		&& sh->geom.width == g->width && sh->geom.height == g->height) {
+		wm.count.geom_elided++;
+		return;
+	}
+
+	swc_window_set_fullscreen(c->win, scr);
+	sh->geom = *g;
+	sh->geom_valid = true;
+	wm.geom_seq++;
+	sh->mode = MODE_FULLSCREEN;
+	wm.count.geom_sent++;
+}
+
+void client_set_geometry(struct client* c, const struct swc_rectangle* geom)
+{
+	struct shadow* sh = &c->sent;
+
+	if (sh->geom_valid
+		&& sh->geom.x == geom->x && sh->geom.y == geom->y
+		&& sh->geom.width == geom->width && sh->geom.height == geom->height) {
+		wm.count.geom_elided++;
+		return;
+	}
+
+	swc_window_set_geometry(c->win, geom);
+	sh->geom = *geom;
+	sh->geom_valid = true;
+	wm.geom_seq++;
+	wm.count.geom_sent++;
+}
+
+void client_set_mode(struct client* c, uint8_t mode, bool force)
+{
+	if (c->sent.mode == mode && !force) {
+		wm.count.mode_elided++;
+		return;
+	}
+
+	/* swc puts a window on top whenever it is (re)stacked */
+	if (mode == MODE_STACKED) {
+		swc_window_set_stacked(c->win);
+		c->sent.stack_seq = ++wm.stack_seq;
+	}
+	else {
+		/* swc may size a window it tiles, the next layout resends ours */
+		swc_window_set_tiled(c->win);
+		c->sent.geom_valid = false;
+		wm.geom_seq++;
+	}
+
+	c->sent.mode = mode;
+	wm.count.mode_sent++;
+}
+
+/* c->scr, ws and tags must still be what attach() saw */
+void detach(struct client* c)
+{
+	if (workspace_of(screen_at(c->scr), c->ws))
+		occupancy_update(occupancy_of(screen_at(c->scr)), c->tags, c->ws, -1);
+	wm.geom_seq++;
+
+	wl_list_remove(&c->tiled_link);
+	wl_list_remove(&c->float_link);
+	wl_list_remove(&c->stack_link);
+	wl_list_init(&c->tiled_link);
+	wl_list_init(&c->float_link);
+	wl_list_init(&c->stack_link);
+}
+
+struct client* first_float(struct screen* s)
+{
+	return next_float(s, NULL);
+}
+
+struct client* first_tiled(struct screen* s)
+{
+	return next_tiled(s, NULL);
 }
 
 bool is_float(const struct client* c, const struct screen* s)
 {
-	return c && c->ws == wm.ws && c->scr == s && c->floating;
+	return c && s && (c->tags & s->tags) && HANDLE_EQ(c->scr, s->id) && c->floating;
+}
+
+bool is_home(const struct client* c, const struct swc_rectangle* g)
+{
+	return c->home.width && c->home.x == g->x && c->home.y == g->y
+		&& c->home.width == g->width && c->home.height == g->height;
 }
 
 bool is_tiled(const struct client* c, const struct screen* s)
 {
-	return c && c->ws == wm.ws && c->scr == s && !c->floating;
+	return c && s && (c->tags & s->tags) && HANDLE_EQ(c->scr, s->id) && !c->floating;
 }
 
 struct client* last_float(struct screen* s)
 {
-	struct client* c;
+	return prev_float(s, NULL);
+}
 
-	wl_list_for_each_reverse(c, &wm.floating, float_link) {
-		if (is_float(c, s))
-			return c;
+struct client* last_tiled(struct screen* s)
+{
+	return prev_tiled(s, NULL);
+}
+
+void log_counters(FILE* fd)
+{
+	const struct counters* n = &wm.count;
+
+	fprintf(fd, "wsxwm: geometry sent=%llu elided=%llu, border sent=%llu elided=%llu, "
+		"mode sent=%llu elided=%llu, layout requested=%llu run=%llu, "
+		"focus noop=%llu deferred=%llu suppressed=%llu, restack sent=%llu elided=%llu, "
+		"warm launched=%llu taken=%llu missed=%llu, status sent=%llu elided=%llu, "
+		"log dropped=%llu, layout deferred=%llu\n",
+		(unsigned long long)n->geom_sent, (unsigned long long)n->geom_elided,
+		(unsigned long long)n->border_sent, (unsigned long long)n->border_elided,
+		(unsigned long long)n->mode_sent, (unsigned long long)n->mode_elided,
+		(unsigned long long)n->layout_requested, (unsigned long long)n->layout_run,
+		(unsigned long long)n->focus_noop, (unsigned long long)n->focus_deferred,
+		(unsigned long long)n->focus_suppressed,
+		(unsigned long long)n->restack_sent, (unsigned long long)n->restack_elided,
+		(unsigned long long)n->warm_launched, (unsigned long long)n->warm_taken,
+		(unsigned long long)n->warm_missed,
+		(unsigned long long)n->status_sent, (unsigned long long)n->status_elided,
+		(unsigned long long)n->log_dropped,
+		(unsigned long long)n->layout_deferred);
+}
+
+/* c is a client shown on s, or NULL to start from the first one */
+struct client* next_float(struct screen* s, struct client* c)
+{
+	return step(s, c, offsetof(struct workspace, floating), offsetof(struct client, float_link), true);
+}
+
+struct client* next_tiled(struct screen* s, struct client* c)
+{
+	return step(s, c, offsetof(struct workspace, tiled), offsetof(struct client, tiled_link), true);
+}
+
+/* a screen's clients moved elsewhere wholesale, see migrate() */
+void occupancy_move(struct occupancy* dst, struct occupancy* src)
+{
+	for (uint32_t i = 0; i < WS_COUNT; i++) {
+		dst->count[i] += src->count[i];
+		dst->nmulti[i] += src->nmulti[i];
 	}
+	dst->mask |= src->mask;
+	dst->multi |= src->multi;
+	*src = (struct occupancy){ 0 };
+}
 
-	return NULL;
+struct occupancy* occupancy_of(struct screen* s)
+{
+	return s ? &s->occ : &wm.limbo_occ;
 }
 
-struct client* last_tiled(struct screen* s)
+void occupancy_update(struct occupancy* o, uint32_t tags, uint32_t ws, int delta)
 {
-	struct client* c;
+	for (uint32_t i = 0; i < WS_COUNT; i++) {
+		if (!(tags & (1u << i)))
+			continue;
 
-	wl_list_for_each_reverse(c, &wm.tiled, tiled_link) {
-		if (is_tiled(c, s))
-			return c;
+		o->count[i] = (uint16_t)(o->count[i] + delta);
+		if (o->count[i])
+			o->mask |= 1u << i;
+		else
+			o->mask &= ~(1u << i);
 	}
 
-	return NULL;
+	if (!(tags & (tags - 1)))
+		return;
+
+	o->nmulti[ws - 1] = (uint16_t)(o->nmulti[ws - 1] + delta);
+	if (o->nmulti[ws - 1])
+		o->multi |= TAG(ws);
+	else
+		o->multi &= ~TAG(ws);
 }
 
-void _log(FILE* fd, const char* fmt, ...)
+struct client* prev_float(struct screen* s, struct client* c)
 {
-	va_list ap;
+	return step(s, c, offsetof(struct workspace, floating), offsetof(struct client, float_link), false);
+}
 
-	fprintf(fd, "wsxwm: ");
+struct client* prev_tiled(struct screen* s, struct client* c)
+{
+	return step(s, c, offsetof(struct workspace, tiled), offsetof(struct client, tiled_link), false);
+}
 
-	va_start(ap, fmt);
-	vfprintf(fd, fmt, ap);
-	va_end(ap);
+struct screen* screen_at(struct handle h)
+{
+	return pool_get(&wm.screen_pool, h);
+}
 
-	fputc('\n', fd);
-	fflush(fd);
+/* workspaces whose lists may hold a client shown with tags */
+uint32_t screen_lists(const struct screen* s, uint32_t tags)
+{
+	return tags | s->occ.multi;
+}
+
+void screen_restack(struct screen* s)
+{
+	uint32_t lists;
+
+	if (!s)
+		return;
+
+	lists = screen_lists(s, s->tags);
+	for (uint32_t i = 1; i <= WS_COUNT; i++) {
+		if (lists & TAG(i))
+			workspace_restack(&s->ws[i - 1]);
+	}
+}
+
+/* shows and hides what changes going to tags with fs as the fullscreen client */
+void screen_view(struct screen* s, uint32_t tags, struct client* fs)
+{
+	uint32_t lists = screen_lists(s, s->tags | tags);
+	struct client* prev_fs = client_at(s->fs);
+	uint32_t prev = s->tags;
+	struct workspace* w;
+	struct client* c;
+	bool was;
+	bool now;
+
+	s->tags = tags;
+	s->sel_ws = tag_first(tags);
+	s->fs = fs ? fs->id : HANDLE_NONE;
+	wm.geom_seq++;
+
+	for (uint32_t i = 1; i <= WS_COUNT; i++) {
+		if (!(lists & TAG(i)))
+			continue;
+
+		w = &s->ws[i - 1];
+		wl_list_for_each(c, &w->floating, float_link) {
+			was = shown(c, prev_fs, prev);
+			now = shown(c, fs, tags);
+			if (was && !now)
+				client_hide(c);
+			else if (now && !was)
+				client_show(c);
+		}
+		wl_list_for_each(c, &w->tiled, tiled_link) {
+			was = shown(c, prev_fs, prev);
+			now = shown(c, fs, tags);
+			if (was && !now)
+				client_hide(c);
+			else if (now && !was)
+				client_show(c);
+		}
+	}
 }
 
 void sig_handler(int s)
@@ -101,21 +439,81 @@ void sig_handler(int s)
 		wl_display_terminate(wm.dpy);
 }
 
-void sync_window_visibility(void)
+/* workspace number of the lowest tag, 0 for none */
+uint32_t tag_first(uint32_t tags)
+{
+	for (uint32_t i = 1; i <= WS_COUNT; i++) {
+		if (tags & TAG(i))
+			return i;
+	}
+
+	return 0;
+}
+
+/* the topmost float over all stacks shown, the global stack_seq orders them */
+struct client* top_float(struct screen* s)
 {
+	struct client* top = NULL;
 	struct client* c;
+	uint32_t lists;
 
-	wl_list_for_each(c, &wm.floating, float_link) {
-		if (c->ws == wm.ws)
-			swc_window_show(c->win);
-		else
-			swc_window_hide(c->win);
+	if (!s)
+		return NULL;
+
+	lists = screen_lists(s, s->tags);
+	for (uint32_t i = 1; i <= WS_COUNT; i++) {
+		if (!(lists & TAG(i)))
+			continue;
+
+		wl_list_for_each(c, &s->ws[i - 1].stack, stack_link) {
+			if (!client_visible(c))
+				continue;
+			if (!top || c->sent.stack_seq > top->sent.stack_seq)
+				top = c;
+			break;
+		}
 	}
 
-	wl_list_for_each(c, &wm.tiled, tiled_link) {
-		if (c->ws == wm.ws)
-			swc_window_show(c->win);
-		else
-			swc_window_hide(c->win);
+	return top;
+}
+
+/*
+ * swc only knows how to put a window on top, so walking from the bottom
+ * every client found below one it belongs above is raised, the rest
+ * are already in order relative to each other
+ */
+void workspace_restack(struct workspace* w)
+{
+	struct client* c;
+	uint64_t top = 0;
+
+	if (!w)
+		return;
+
+	wl_list_for_each_reverse(c, &w->stack, stack_link) {
+		if (c->fullscreen)
+			continue;
+		if (c->sent.stack_seq < top) {
+			client_set_mode(c, MODE_STACKED, true);
+			wm.count.restack_sent++;
+		}
+		else {
+			wm.count.restack_elided++;
+		}
+		top = c->sent.stack_seq;
 	}
 }
+
+struct workspace* workspace_cur(struct screen* s)
+{
+	return s ? workspace_of(s, s->sel_ws) : NULL;
+}
+
+/* without a screen the client is parked in wm.limbo until one appears */
+struct workspace* workspace_of(struct screen* s, uint32_t ws)
+{
+	if (ws < 1 || ws > WS_COUNT)
+		return NULL;
+
+	return s ? &s->ws[ws - 1] : &wm.limbo[ws - 1];
+}
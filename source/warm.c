@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <wayland-server.h>
+
+#include "launch.h"
+#include "log.h"
+#include "pool.h"
+#include "stats.h"
+#include "types.h"
+#include "util.h"
+#include "warm.h"
+#include "wsxwm.h"
+
+/*
+ * keeps instances of some commands started ahead of time, so spawn() can
+ * show a window that already exists. swc does not say which process a
+ * window belongs to, the windows are recognised by app_id while a launch
+ * of the pool is waiting for one, and each is paired with the oldest such
+ * launch. a launch waits wait_ms for its window and is given up on after,
+ * so a stray window with the same app_id can only be taken in meanwhile.
+ * windows are parked unshown on no workspace (ws 0) until warm_take()
+ * hands one out, and the pool is topped up from a timer afterwards, never
+ * from within the binding that took one.
+ */
+
+struct warm_launch {
+	pid_t          pid;
+	uint64_t       due;         /* stats_now() its window is waited for until */
+	struct handle  c;           /* its parked window, HANDLE_NONE while waited for */
+};
+
+struct warm_state {
+	const struct warm_pool* cfg;
+	struct wl_list ready;       /* parked clients by tiled_link, oldest first */
+	uint32_t       nready;
+	struct warm_launch* launches; /* started and not handed out, oldest first */
+	uint32_t       nlaunches;
+	struct wl_event_source* refill;
+};
+
+static bool argv_eq(const char* const* a, char* const* b);
+static void drop(struct warm_state* st, struct warm_launch* l);
+static struct warm_launch* launch_of(struct warm_state* st, const struct client* c);
+static void on_child_exited(struct child* ch);
+static int on_refill(void* data);
+static void refill(struct warm_state* st);
+static uint64_t rss_kb(const struct warm_state* st);
+static void schedule(struct warm_state* st, uint32_t ms);
+static struct warm_launch* waiting(struct warm_state* st);
+
+static struct warm_state* states = NULL;
+static size_t nstates = 0;
+
+static bool argv_eq(const char* const* a, char* const* b)
+{
+	if ((const void*)a == (const void*)b)
+		return true;
+
+	for (; *a && *b; a++, b++) {
+		if (strcmp(*a, *b) != 0)
+			return false;
+	}
+
+	return !*a && !*b;
+}
+
+/* l no longer counts as an instance of the pool, its process is left alone */
+static void drop(struct warm_state* st, struct warm_launch* l)
+{
+	size_t i = (size_t)(l - st->launches);
+
+	memmove(l, l + 1, (st->nlaunches - i - 1) * sizeof(*l));
+	st->nlaunches--;
+}
+
+/* the launch c was paired with when it was parked */
+static struct warm_launch* launch_of(struct warm_state* st, const struct client* c)
+{
+	for (uint32_t i = 0; i < st->nlaunches; i++) {
+		if (HANDLE_EQ(st->launches[i].c, c->id))
+			return &st->launches[i];
+	}
+
+	return NULL;
+}
+
+/* an instance nobody took died, it is replaced on the next take, not now */
+static void on_child_exited(struct child* ch)
+{
+	struct warm_state* st = ch->data;
+
+	for (uint32_t i = 0; i < st->nlaunches; i++) {
+		if (st->launches[i].pid == ch->pid) {
+			drop(st, &st->launches[i]);
+			return;
+		}
+	}
+}
+
+static int on_refill(void* data)
+{
+	refill(data);
+	return 0;
+}
+
+static void refill(struct warm_state* st)
+{
+	const struct warm_pool* p = st->cfg;
+	struct child* ch;
+
+	while (st->nlaunches < p->size) {
+		if (p->max_rss_kb && rss_kb(st) >= p->max_rss_kb) {
+			log_warn("warm %s: %u instances reach the %u KiB cap", p->app_id, st->nlaunches, p->max_rss_kb);
+			return;
+		}
+
+		ch = launch_spawn((char* const*)p->argv, 0);
+		if (!ch)
+			return;
+
+		ch->data = st;
+		ch->exited = on_child_exited;
+		st->launches[st->nlaunches++] = (struct warm_launch){
+			ch->pid, stats_now() + (uint64_t)p->wait_ms * 1000000, HANDLE_NONE,
+		};
+		wm.count.warm_launched++;
+	}
+}
+
+/* resident size of the instances not handed out, 0 where /proc is missing */
+static uint64_t rss_kb(const struct warm_state* st)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	unsigned long size;
+	unsigned long resident;
+	uint64_t kb = 0;
+	char path[32];
+	FILE* fd;
+
+	for (uint32_t i = 0; i < st->nlaunches; i++) {
+		snprintf(path, sizeof(path), "/proc/%d/statm", (int)st->launches[i].pid);
+		fd = fopen(path, "r");
+		if (!fd)
+			continue;
+		if (fscanf(fd, "%lu %lu", &size, &resident) == 2)
+			kb += (uint64_t)resident * (uint64_t)page / 1024;
+		fclose(fd);
+	}
+
+	return kb;
+}
+
+static void schedule(struct warm_state* st, uint32_t ms)
+{
+	if (st->refill)
+		wl_event_source_timer_update(st->refill, ms ? (int)ms : 1);
+}
+
+/* the oldest launch still waiting for its window, those past wait_ms are dropped */
+static struct warm_launch* waiting(struct warm_state* st)
+{
+	uint64_t now = stats_now();
+	struct warm_launch* l;
+
+	for (uint32_t i = 0; i < st->nlaunches;) {
+		l = &st->launches[i];
+		if (!HANDLE_EQ(l->c, HANDLE_NONE)) {
+			i++;
+			continue;
+		}
+		if (l->due > now)
+			return l;
+
+		log_warn("warm %s: pid %d showed no window within %u ms", st->cfg->app_id, (int)l->pid, st->cfg->wait_ms);
+		drop(st, l);
+	}
+
+	return NULL;
+}
+
+void warm_finish(void)
+{
+	struct child* ch;
+
+	for (size_t i = 0; i < nstates; i++) {
+		/* the children outlive this table until they are reaped */
+		for (uint32_t j = 0; j < states[i].nlaunches; j++) {
+			ch = launch_find(states[i].launches[j].pid);
+			if (ch)
+				ch->exited = NULL;
+		}
+		if (states[i].refill)
+			wl_event_source_remove(states[i].refill);
+		free(states[i].launches);
+	}
+
+	free(states);
+	states = NULL;
+	nstates = 0;
+}
+
+/* the first instances are started once the loop runs, not during setup */
+void warm_init(const struct warm_pool* pools, size_t n)
+{
+	if (n == 0)
+		return;
+
+	states = calloc(n, sizeof(*states));
+	if (!states) {
+		log_warn("warm pool table unavailable");
+		return;
+	}
+	nstates = n;
+
+	for (size_t i = 0; i < n; i++) {
+		struct warm_state* st = &states[i];
+
+		st->cfg = &pools[i];
+		wl_list_init(&st->ready);
+		if (pools[i].size == 0)
+			continue;
+
+		st->launches = calloc(pools[i].size, sizeof(*st->launches));
+		st->refill = wl_event_loop_add_timer(wm.ev_loop, on_refill, st);
+		if (!st->launches || !st->refill) {
+			log_warn("warm %s unavailable", pools[i].app_id);
+			free(st->launches);
+			st->launches = NULL;
+			if (st->refill)
+				wl_event_source_remove(st->refill);
+			st->refill = NULL;
+			continue;
+		}
+		schedule(st, 1);
+	}
+}
+
+/* parks c if its app_id is one a launch of the pool is waiting for */
+bool warm_park(struct client* c)
+{
+	const char* app_id = c->win->app_id;
+	struct warm_launch* l;
+
+	if (!app_id)
+		return false;
+
+	for (size_t i = 0; i < nstates; i++) {
+		struct warm_state* st = &states[i];
+
+		if (strcmp(st->cfg->app_id, app_id) != 0 || !(l = waiting(st)))
+			continue;
+
+		l->c = c->id;
+		c->warm = (uint8_t)(i + 1);
+		c->ws = 0;
+		c->tags = 0;
+		wl_list_insert(st->ready.prev, &c->tiled_link);
+		st->nready++;
+		return true;
+	}
+
+	return false;
+}
+
+/* a launch is still waiting for its window */
+bool warm_pending(void)
+{
+	for (size_t i = 0; i < nstates; i++) {
+		if (waiting(&states[i]))
+			return true;
+	}
+
+	return false;
+}
+
+/* a parked window went away, its launch is no longer an instance */
+void warm_release(struct client* c)
+{
+	struct warm_state* st;
+	struct warm_launch* l;
+
+	if (!c->warm || c->warm > nstates)
+		return;
+
+	st = &states[c->warm - 1];
+	wl_list_remove(&c->tiled_link);
+	wl_list_init(&c->tiled_link);
+	st->nready--;
+	l = launch_of(st, c);
+	if (l)
+		drop(st, l);
+	c->warm = 0;
+}
+
+/* NULL if argv has no pool or none of its instances is ready yet */
+struct client* warm_take(char* const* argv)
+{
+	struct warm_state* st;
+	struct warm_launch* l;
+	struct client* c;
+
+	for (size_t i = 0; i < nstates; i++) {
+		st = &states[i];
+		if (!st->launches || !argv_eq(st->cfg->argv, argv))
+			continue;
+
+		if (!st->nready) {
+			wm.count.warm_missed++;
+			return NULL;
+		}
+
+		c = wl_container_of(st->ready.next, c, tiled_link);
+		wl_list_remove(&c->tiled_link);
+		wl_list_init(&c->tiled_link);
+		st->nready--;
+		c->warm = 0;
+
+		l = launch_of(st, c);
+		if (l)
+			drop(st, l);
+
+		wm.count.warm_taken++;
+		schedule(st, st->cfg->refill_ms);
+		return c;
+	}
+
+	return NULL;
+}
@@ -1,7 +1,7 @@
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
+#include <string.h>
 
 #include <swc.h>
 #include <wayland-server.h>
@@ -9,112 +9,794 @@
 #include <xkbcommon/xkbcommon-keysyms.h>
 
 #include "config.h"
+#include "ipc.h"
+#include "launch.h"
+#include "log.h"
+#include "pool.h"
+#include "rules.h"
+#include "spatial.h"
+#include "stats.h"
+#include "status.h"
+#include "trace.h"
 #include "types.h"
 #include "util.h"
+#include "warm.h"
 #include "wsxwm.h"
 
+static void adopt_client(struct client* c, struct screen* from, struct screen* to);
+static bool adopt_from(struct screen* s, struct screen* from);
+static void cleanup(void);
+static void dir_origin(const struct client* c, const struct screen* s, uint32_t dir, struct swc_rectangle* out);
 static void focus(struct client* c, bool raise);
+static struct client* front_of(struct screen* s);
+static void apply_rule(struct client* c, const struct rule* r);
+static void hold(struct client* c);
+static void hold_arm(void);
+static void input_issued(size_t action, uint32_t time, bool laid_out);
+static void layout_flush(void);
+static void map_client(struct client* c, const struct rule* r);
+static void migrate(struct screen* from, struct screen* to);
+static void migrate_client(struct client* c, struct screen* from, struct screen* to);
+static void move_client(struct client* c, struct screen* to, bool was_visible);
+static void retag(struct client* c, uint32_t tags);
+static void reveal(struct client* c);
+static int on_focus_timer(void* data);
+static int on_hold_timer(void* data);
+static void on_layout_idle(void* data);
+static int on_layout_timer(void* data);
 static void on_screen_destroy(void* data);
+static void on_screen_entered(void* data);
+static void on_screen_geometry_changed(void* data);
 static void on_screen_usable_geometry_changed(void* data);
+static int on_sigusr1(int sig, void* data);
+static void on_win_app_id_changed(void* data);
 static void on_win_destroy(void* data);
 static void on_win_entered(void* data);
+static void on_win_title_changed(void* data);
+static void run_bind(void* data, uint32_t time, uint32_t value, uint32_t state);
 static void setup(void);
 static void setup_binds(void);
+static void set_covered(struct client* c, bool on);
 static void set_floating(struct client* c, bool floating, bool raise);
+static void set_fullscreen(struct client* c, bool on);
+static bool set_tags(struct client* c, uint32_t tags);
+static void set_throttle(struct client* c);
+static void swap_links(struct wl_list* a, struct wl_list* b);
+static bool place(struct client* c, const struct rule* r);
+static void screen_adopt(struct screen* s);
+static struct screen* screen_nth(int32_t n);
+static void screen_refresh(struct screen* s);
 static void tile(struct screen* s);
+static void tile_screen(struct screen* s);
+static bool tiled_on(const struct client* c, const struct screen* s);
+static void timed_new_screen(struct swc_screen* scr);
+static void timed_new_window(struct swc_window* win);
+static void timed_screen_geometry(void* data);
+static void timed_win_destroy(void* data);
+static void timed_win_entered(void* data);
+static void view_tags(struct screen* s, uint32_t tags);
 
 /* master width in px */
 static uint32_t master_width = 0;
 
+/* layout output, grown on demand and never shrunk */
+static struct swc_rectangle* rects = NULL;
+static size_t rects_cap = 0;
+
+static const struct action actions[] = {
+	{ "cycle_layout",        cycle_layout,        ARG_NONE },
+	{ "focus_dir",           focus_dir,           ARG_DIR },
+	{ "focus_next",          focus_next,          ARG_NONE },
+	{ "focus_prev",          focus_prev,          ARG_NONE },
+	{ "kill_sel",            kill_sel,            ARG_NONE },
+	{ "master_next",         master_next,         ARG_NONE },
+	{ "master_prev",         master_prev,         ARG_NONE },
+	{ "master_resize",       master_resize,       ARG_INT },
+	{ "mouse_move",          mouse_move,          ARG_POINTER },
+	{ "mouse_resize",        mouse_resize,        ARG_POINTER },
+	{ "move_dir",            move_dir,            ARG_DIR },
+	{ "quit",                quit,                ARG_NONE },
+	{ "set_layout",          set_layout,          ARG_LAYOUT },
+	{ "spawn",               spawn,               ARG_CMD },
+	{ "swap_dir",            swap_dir,            ARG_DIR },
+	{ "tag",                 tag,                 ARG_UINT },
+	{ "toggle_float",        toggle_float,        ARG_NONE },
+	{ "toggle_float_global", toggle_float_global, ARG_NONE },
+	{ "toggle_fullscreen",   toggle_fullscreen,   ARG_NONE },
+	{ "toggle_tag",          toggle_tag,          ARG_UINT },
+	{ "toggle_view",         toggle_view,         ARG_UINT },
+	{ "view",                view,                ARG_UINT },
+	{ "workspace_cycle",     workspace_cycle,     ARG_INT },
+	{ "workspace_goto",      workspace_goto,      ARG_UINT },
+	{ "workspace_moveto",    workspace_moveto,    ARG_UINT },
+};
+
+/* per action latency, last slot collects binds to unlisted functions */
+static struct hist action_hist[LENGTH(actions) + 1];
+static size_t bind_action[LENGTH(binds)];
+
+/*
+ * the same from the input event, once to the handler running, which is
+ * the queueing on this thread, and once to its focus and layout going out
+ */
+static struct hist input_hist[LENGTH(actions) + 1];
+static struct hist issued_hist[LENGTH(actions) + 1];
+static struct input_pending input_pending[16];
+static size_t ninput_pending = 0;
+
 struct wm wm;
 const struct swc_manager manager = {
-	.new_screen = new_screen, .new_window = new_window, .new_device = new_device,
+	.new_screen = timed_new_screen, .new_window = timed_new_window, .new_device = new_device,
 };
 struct swc_window_handler window_handler = {
-	.destroy = on_win_destroy, .entered = on_win_entered,
+	.destroy = timed_win_destroy, .entered = timed_win_entered,
+	.title_changed = on_win_title_changed, .app_id_changed = on_win_app_id_changed,
 };
 struct swc_screen_handler screen_handler = {
 	.destroy = on_screen_destroy,
-	.usable_geometry_changed = on_screen_usable_geometry_changed,
+	.geometry_changed = on_screen_geometry_changed,
+	.usable_geometry_changed = timed_screen_geometry,
+	.entered = on_screen_entered,
 };
 
+/* the client fields a rule sets, c must not be attached */
+static void apply_rule(struct client* c, const struct rule* r)
+{
+	struct screen* s = screen_nth(r->screen);
+
+	if (s)
+		c->scr = s->id;
+	if (r->ws >= 1 && r->ws <= WS_COUNT)
+		c->tags = TAG(r->ws);
+	else if (s)
+		c->tags = s->tags;
+	c->ws = tag_first(c->tags);
+	if (r->floating >= 0)
+		c->floating = r->floating;
+}
+
+/* the per client part of adopt_from(), the lists are spliced by the caller */
+static void adopt_client(struct client* c, struct screen* from, struct screen* to)
+{
+	bool was = client_visible(c);
+
+	occupancy_update(occupancy_of(from), c->tags, c->ws, -1);
+	occupancy_update(occupancy_of(to), c->tags, c->ws, 1);
+	c->home = (struct swc_rectangle){ 0 };
+	c->scr = to->id;
+	set_throttle(c);
+	wm.geom_seq++;
+
+	if (client_visible(c) == was)
+		return;
+	if (was)
+		client_hide(c);
+	else
+		client_show(c);
+}
+
+/*
+ * move the clients of from (NULL for limbo) whose home is s to s. they
+ * are taken out of each list in order and spliced onto s's as migrate()
+ * does, so they come back in the order they left
+ */
+static bool adopt_from(struct screen* s, struct screen* from)
+{
+	const struct swc_rectangle* g = &s->scr->geometry;
+	struct wl_list tiled;
+	struct wl_list floating;
+	struct wl_list stack;
+	struct workspace* src;
+	struct workspace* dst;
+	struct client* c;
+	struct client* next;
+	bool moved = false;
+
+	/* fullscreen belongs to a screen, it does not travel */
+	if (from && client_at(from->fs) && is_home(client_at(from->fs), g))
+		set_fullscreen(client_at(from->fs), false);
+
+	for (uint32_t i = 1; i <= WS_COUNT; i++) {
+		src = workspace_of(from, i);
+		dst = workspace_of(s, i);
+		wl_list_init(&tiled);
+		wl_list_init(&floating);
+		wl_list_init(&stack);
+
+		wl_list_for_each_safe(c, next, &src->tiled, tiled_link) {
+			if (is_home(c, g)) {
+				wl_list_remove(&c->tiled_link);
+				wl_list_insert(tiled.prev, &c->tiled_link);
+			}
+		}
+		wl_list_for_each_safe(c, next, &src->floating, float_link) {
+			if (is_home(c, g)) {
+				wl_list_remove(&c->float_link);
+				wl_list_insert(floating.prev, &c->float_link);
+			}
+		}
+		wl_list_for_each_safe(c, next, &src->stack, stack_link) {
+			if (is_home(c, g)) {
+				wl_list_remove(&c->stack_link);
+				wl_list_insert(stack.prev, &c->stack_link);
+			}
+		}
+
+		wl_list_for_each(c, &tiled, tiled_link)
+			adopt_client(c, from, s);
+		wl_list_for_each(c, &floating, float_link)
+			adopt_client(c, from, s);
+		moved |= !wl_list_empty(&tiled) || !wl_list_empty(&floating);
+
+		/* returning floats go on top, the restack below raises them */
+		wl_list_insert_list(dst->tiled.prev, &tiled);
+		wl_list_insert_list(dst->floating.prev, &floating);
+		wl_list_insert_list(&dst->stack, &stack);
+	}
+
+	if (moved)
+		screen_restack(s);
+
+	return moved;
+}
+
+/* drops the sources setup() added to the loop, before the display goes */
+static void cleanup(void)
+{
+	struct wl_event_source** src[] = {
+		&wm.layout_idle, &wm.focus_timer, &wm.hold_timer, &wm.layout_timer, &wm.sigusr1,
+	};
+
+	for (size_t i = 0; i < LENGTH(src); i++) {
+		if (*src[i])
+			wl_event_source_remove(*src[i]);
+		*src[i] = NULL;
+	}
+	wm.layout_waiting = false;
+}
+
+/* where a directional search starts, the far side of the usable area without c's geometry */
+static void dir_origin(const struct client* c, const struct screen* s, uint32_t dir, struct swc_rectangle* out)
+{
+	const struct swc_rectangle* u = &s->scr->usable_geometry;
+
+	if (c && c->sent.geom_valid && client_visible(c)) {
+		*out = c->sent.geom;
+		return;
+	}
+
+	*out = *u;
+	switch (dir) {
+	case DIR_LEFT:
+		out->x += (int32_t)u->width;
+		/* fallthrough */
+	case DIR_RIGHT:
+		out->width = 0;
+		break;
+	case DIR_UP:
+		out->y += (int32_t)u->height;
+		/* fallthrough */
+	case DIR_DOWN:
+		out->height = 0;
+		break;
+	}
+}
+
 static void focus(struct client* c, bool raise)
 {
-	if (wm.sel_client)
-		swc_window_set_border(
-			wm.sel_client->win,
-			cfg.border_col_normal, cfg.border_width,
-			0, 0
-		);
+	struct client* sel = client_at(wm.sel_client);
+	struct client* prev;
+	struct screen* s;
+	uint64_t t0;
+
+	/* an explicit focus wins over a pending pointer one */
+	wm.focus_pending = HANDLE_NONE;
+
+	if (c == sel) {
+		wm.count.focus_noop++;
+		return;
+	}
+
+	t0 = stats_now();
+
+	if (sel)
+		client_set_border(sel, cfg.border_col_normal, sel->fullscreen ? 0 : cfg.border_width);
 
 	if (c)
-		swc_window_set_border(
-			c->win,
-			cfg.border_col_active, cfg.border_width,
-			0, 0
-		);
+		client_set_border(c, cfg.border_col_active, c->fullscreen ? 0 : cfg.border_width);
 
-	if (raise && c && c->floating)
+	if (raise && c && c->floating && !c->fullscreen)
 		set_floating(c, true, true);
 
+	/* a single layout shows what gets focus in place of what it showed */
+	if (c && c->covered) {
+		s = screen_at(c->scr);
+		prev = front_of(s);
+		set_covered(c, false);
+		if (prev && prev != c)
+			set_covered(prev, true);
+		s->front = c->id;
+	}
+
 	swc_window_focus(c ? c->win : NULL);
-	wm.sel_client = c;
+	wm.sel_client = c ? c->id : HANDLE_NONE;
+	if (c && screen_at(c->scr))
+		wm.sel_screen = c->scr;
+	status_touch();
+
+	hist_record(&stats[STAT_FOCUS], stats_now() - t0);
+}
+
+/* the tiled client a single layout on s shows, if it still does */
+static struct client* front_of(struct screen* s)
+{
+	struct client* c = client_at(s->front);
+
+	return tiled_on(c, s) ? c : NULL;
+}
+
+/* an action issued its changes, or asked for a layout pass that will */
+static void input_issued(size_t action, uint32_t time, bool laid_out)
+{
+	if (!laid_out || (!wm.layout_idle && !wm.layout_waiting) || ninput_pending == LENGTH(input_pending)) {
+		hist_record(&issued_hist[action], stats_input_age(time, stats_now()));
+		return;
+	}
+
+	input_pending[ninput_pending].time = time;
+	input_pending[ninput_pending].action = (uint32_t)action;
+	ninput_pending++;
+}
+
+/*
+ * shown once its app_id is known to warm_park() and the rules, or after
+ * warm_hold_ms while a warm launch is out and rule_hold_ms otherwise.
+ * wm.held is kept in deadline order
+ */
+static void hold(struct client* c)
+{
+	uint32_t ms = warm_pending() ? cfg.warm_hold_ms : cfg.rule_hold_ms;
+	struct wl_list* pos;
+	struct client* o;
+
+	c->held_until = stats_now() + (uint64_t)ms * 1000000;
+	for (pos = wm.held.prev; pos != &wm.held; pos = pos->prev) {
+		o = wl_container_of(pos, o, tiled_link);
+		if (o->held_until <= c->held_until)
+			break;
+	}
+	wl_list_insert(pos, &c->tiled_link);
+	hold_arm();
+}
+
+/* the hold timer goes off at the first deadline on wm.held */
+static void hold_arm(void)
+{
+	struct client* c;
+	uint64_t now;
+	uint64_t ms = 0;
+
+	if (!wl_list_empty(&wm.held)) {
+		c = wl_container_of(wm.held.next, c, tiled_link);
+		now = stats_now();
+		ms = c->held_until > now ? (c->held_until - now + 999999) / 1000000 : 1;
+	}
+	wl_event_source_timer_update(wm.hold_timer, (int)ms);
+}
+
+static void layout_flush(void)
+{
+	struct screen* s;
+
+	if (wm.layout_idle) {
+		wl_event_source_remove(wm.layout_idle);
+		wm.layout_idle = NULL;
+	}
+	if (wm.layout_waiting) {
+		wl_event_source_timer_update(wm.layout_timer, 0);
+		wm.layout_waiting = false;
+	}
+
+	wl_list_for_each(s, &wm.screens, link) {
+		if (!s->dirty)
+			continue;
+
+		s->dirty = false;
+		TIMED(&stats[STAT_TILE], tile_screen(s));
+	}
+	wm.layout_last = stats_now();
+
+	if (ninput_pending) {
+		uint64_t now = stats_now();
+
+		for (size_t i = 0; i < ninput_pending; i++)
+			hist_record(&issued_hist[input_pending[i].action], stats_input_age(input_pending[i].time, now));
+		ninput_pending = 0;
+	}
+}
+
+static int on_focus_timer(void* data)
+{
+	(void)data;
+
+	struct client* c = client_at(wm.focus_pending);
+
+	wm.focus_pending = HANDLE_NONE;
+	if (!c || !client_visible(c) || wm.grab.active)
+		return 0;
+
+	wm.count.focus_deferred++;
+	focus(c, true);
+	return 0;
+}
+
+/* puts c on the selected screen's workspace, or where r sends it, and shows it */
+static void map_client(struct client* c, const struct rule* r)
+{
+	struct screen* s;
+	struct client* fs;
+	bool own;
+
+	c->scr = wm.sel_screen;
+	c->floating = wm.global_floating;
+	c->tags = screen_at(c->scr) ? screen_at(c->scr)->tags : TAG(1);
+	c->ws = tag_first(c->tags);
+	c->mapped = true;
+	if (r)
+		apply_rule(c, r);
+	set_throttle(c);
+
+	/* dialogs and floats go above a fullscreen client they land under, anything else ends it */
+	s = screen_at(c->scr);
+	fs = s ? client_at(s->fs) : NULL;
+	if (fs && client_visible(fs) && (c->tags & s->tags)) {
+		own = c->win->app_id && fs->win->app_id && strcmp(c->win->app_id, fs->win->app_id) == 0;
+		if (c->floating || c->win->parent || own) {
+			c->floating = true;
+			c->over = fs->id;
+		}
+		else {
+			set_fullscreen(fs, false);
+		}
+	}
+
+	attach(c);
+	client_set_mode(c, c->floating ? MODE_STACKED : MODE_TILED, false);
+	if (!client_visible(c))
+		return;
+
+	/* the first configure carries the final size, the first frame is drawn at it */
+	if (place(c, r))
+		client_show(c);
+	else
+		c->show_pending = true;
+	focus(c, true);
+}
+
+/*
+ * move every client of from to the same workspace on to, NULL standing
+ * for wm.limbo; the lists are spliced whole, so past fixing up c->scr the
+ * cost is one layout of to however many clients move
+ */
+static void migrate(struct screen* from, struct screen* to)
+{
+	struct workspace* src;
+	struct workspace* dst;
+	struct client* c;
+	bool moved = false;
+
+	/* fullscreen belongs to a screen, it does not travel */
+	if (from && client_at(from->fs))
+		set_fullscreen(client_at(from->fs), false);
+
+	for (uint32_t i = 1; i <= WS_COUNT; i++) {
+		src = workspace_of(from, i);
+		dst = workspace_of(to, i);
+		moved |= !wl_list_empty(&src->tiled) || !wl_list_empty(&src->floating);
+
+		wl_list_for_each(c, &src->tiled, tiled_link)
+			migrate_client(c, from, to);
+		wl_list_for_each(c, &src->floating, float_link)
+			migrate_client(c, from, to);
+
+		/* moved floats go on top, the restack below raises them */
+		wl_list_insert_list(dst->tiled.prev, &src->tiled);
+		wl_list_insert_list(dst->floating.prev, &src->floating);
+		wl_list_insert_list(&dst->stack, &src->stack);
+		wl_list_init(&src->tiled);
+		wl_list_init(&src->floating);
+		wl_list_init(&src->stack);
+	}
+
+	occupancy_move(occupancy_of(to), occupancy_of(from));
+
+	if (to && moved) {
+		screen_restack(to);
+		tile(to);
+	}
+}
+
+/* the per client part of migrate(), the lists are spliced by the caller */
+static void migrate_client(struct client* c, struct screen* from, struct screen* to)
+{
+	bool was = client_visible(c);
+
+	/* only the first output matters, a chain of unplugs still goes home */
+	if (from && !c->home.width)
+		c->home = from->scr->geometry;
+
+	c->scr = to ? to->id : HANDLE_NONE;
+	set_throttle(c);
+	wm.geom_seq++;
+
+	if (client_visible(c) == was)
+		return;
+	if (was)
+		client_hide(c);
+	else
+		client_show(c);
+}
+
+/* single client version of migrate(), c keeps its workspace */
+static void move_client(struct client* c, struct screen* to, bool was_visible)
+{
+	if (c->fullscreen)
+		set_fullscreen(c, false);
+
+	c->home = (struct swc_rectangle){ 0 };
+	detach(c);
+	c->scr = to->id;
+	attach(c);
+	set_throttle(c);
+
+	if (client_visible(c)) {
+		if (!was_visible)
+			client_show(c);
+		if (c->floating)
+			client_set_mode(c, MODE_STACKED, true);
+	}
+	else if (was_visible) {
+		client_hide(c);
+	}
+}
+
+static int on_hold_timer(void* data)
+{
+	struct client* c;
+	struct client* tmp;
+	uint64_t now;
+
+	(void)data;
+
+	now = stats_now();
+	wl_list_for_each_safe(c, tmp, &wm.held, tiled_link) {
+		if (c->held_until > now)
+			break;
+
+		wl_list_remove(&c->tiled_link);
+		wl_list_init(&c->tiled_link);
+		map_client(c, rules_match(&wm.rule_index, c->win->app_id, c->win->title));
+	}
+	hold_arm();
+
+	return 0;
+}
+
+static void on_layout_idle(void* data)
+{
+	(void)data;
+
+	/* the loop frees idle sources once they have fired */
+	wm.layout_idle = NULL;
+	layout_flush();
+}
+
+static int on_layout_timer(void* data)
+{
+	(void)data;
+
+	wm.layout_waiting = false;
+	layout_flush();
+	return 0;
 }
 
 static void on_screen_destroy(void* data)
 {
 	struct screen* s = data;
+	struct screen* next = NULL;
+	struct client* c;
 
 	if (!s)
 		return;
 
+	trace_screen(TRACE_SCREEN_DESTROY, s->scr, NULL, 0);
+
 	wl_list_remove(&s->link);
 
-	if (wm.sel_screen == s) {
-		if (wl_list_empty(&wm.screens))
-			wm.sel_screen = NULL;
-		else
-			wm.sel_screen = wl_container_of(wm.screens.next, wm.sel_screen, link);
+	/* clients go where the user is, or to limbo if s was the last one */
+	if (!wl_list_empty(&wm.screens)) {
+		next = screen_at(wm.sel_screen);
+		if (!next || next == s)
+			next = wl_container_of(wm.screens.next, next, link);
 	}
 
-	free(s);
+	if (screen_at(wm.sel_screen) == s)
+		wm.sel_screen = next ? next->id : HANDLE_NONE;
+
+	migrate(s, next);
+	spatial_finish(&s->index);
+	pool_free(&wm.screen_pool, s->id);
+
+	/* the focused client may have landed on a hidden workspace */
+	c = client_at(wm.sel_client);
+	if (c && !client_visible(c)) {
+		wm.sel_client = HANDLE_NONE;
+		c = top_float(next);
+		if (!c)
+			c = first_tiled(next);
+		focus(c, true);
+	}
+}
+
+/* the pointer crossed onto s, new windows and workspace keys go there */
+static void on_screen_entered(void* data)
+{
+	struct screen* s = data;
+
+	if (!s)
+		return;
+
+	trace_screen(TRACE_SCREEN_ENTERED, s->scr, NULL, 0);
+	if (!HANDLE_EQ(wm.sel_screen, s->id))
+		status_touch();
+	wm.sel_screen = s->id;
+}
+
+static void on_screen_geometry_changed(void* data)
+{
+	struct screen* s = data;
+	struct client* c;
+	uint32_t hz = s->refresh_hz;
+
+	trace_screen(TRACE_SCREEN_GEOMETRY, s->scr, &s->scr->geometry, 0);
+
+	/* a returning output may only now report the geometry it had */
+	screen_adopt(s);
+
+	/* a fullscreen client follows the output's size */
+	if (client_at(s->fs))
+		tile(s);
+
+	/* a mode change may come with a new refresh rate */
+	screen_refresh(s);
+	if (s->refresh_hz == hz)
+		return;
+
+	for (uint32_t i = 0; i < WS_COUNT; i++) {
+		wl_list_for_each(c, &s->ws[i].tiled, tiled_link)
+			set_throttle(c);
+		wl_list_for_each(c, &s->ws[i].floating, float_link)
+			set_throttle(c);
+	}
 }
 
 static void on_screen_usable_geometry_changed(void* data)
 {
 	struct screen* s = data;
 
+	/* the usable area's edges are snapped to */
+	wm.geom_seq++;
 	tile(s);
 }
 
+static int on_sigusr1(int sig, void* data)
+{
+	(void)sig;
+	(void)data;
+
+	log_flush();
+	dump_stats(stderr);
+	return 0;
+}
+
+/* most clients set app_id after the window exists, match again once */
+static void on_win_app_id_changed(void* data)
+{
+	struct client* c = data;
+	struct screen* from;
+	struct screen* to;
+	struct client* next;
+	const struct rule* r;
+	bool was;
+
+	if (!c || c->warm || !c->win->app_id)
+		return;
+
+	/* rules see the first app_id only, the status line every one */
+	if (client_at(wm.sel_client) == c)
+		status_touch();
+	if (c->ruled)
+		return;
+
+	c->ruled = true;
+	r = rules_match(&wm.rule_index, c->win->app_id, c->win->title);
+	trace_window(TRACE_WIN_APP_ID, c->win, r ? (uint16_t)(r - rules + 1) : 0);
+
+	/* held back by new_window until now */
+	if (!c->mapped) {
+		wl_list_remove(&c->tiled_link);
+		wl_list_init(&c->tiled_link);
+		if (!warm_park(c))
+			map_client(c, r);
+		return;
+	}
+
+	if (!r)
+		return;
+
+	if (c->fullscreen)
+		set_fullscreen(c, false);
+
+	from = screen_at(c->scr);
+	was = client_visible(c);
+
+	detach(c);
+	apply_rule(c, r);
+	attach(c);
+
+	to = screen_at(c->scr);
+	if (to)
+		move_client(c, to, was);
+	client_set_mode(c, c->floating ? MODE_STACKED : MODE_TILED, false);
+	place(c, r);
+
+	tile(from);
+	if (to != from)
+		tile(to);
+
+	if (client_at(wm.sel_client) == c && !client_visible(c)) {
+		wm.sel_client = HANDLE_NONE;
+		next = top_float(from);
+		if (!next)
+			next = first_tiled(from);
+		focus(next, true);
+	}
+}
+
 static void on_win_destroy(void* data)
 {
 	struct client* c = data;
 	struct client* next;
+	struct screen* s;
 
 	if (!c)
 		return;
 
-	if (wm.grab.active && wm.grab.c == c) {
+	if (wm.grab.active && client_at(wm.grab.c) == c) {
 		wm.grab.active = false;
-		wm.grab.c = NULL;
+		wm.grab.c = HANDLE_NONE;
 	}
 
-	if (c->floating)
-		wl_list_remove(&c->float_link);
-	else
-		wl_list_remove(&c->tiled_link);
+	warm_release(c);
+
+	/* what it covered comes back with the layout pass below */
+	s = c->mapped ? screen_at(c->scr) : NULL;
+	if (s && c->fullscreen)
+		screen_view(s, s->tags, NULL);
 
-	if (wm.sel_client == c) {
-		wm.sel_client = NULL;
-		next = first_float(c->scr);
+	detach(c);
+
+	if (client_at(wm.sel_client) == c) {
+		wm.sel_client = HANDLE_NONE;
+		next = top_float(s);
 		if (!next)
-			next = first_tiled(c->scr);
+			next = first_tiled(s);
 		focus(next, true);
 	}
 
-	tile(c->scr);
-	free(c);
+	if (s)
+		tile(s);
+	pool_free(&wm.client_pool, c->id);
 }
 
 static void on_win_entered(void* data)
@@ -123,10 +805,90 @@ static void on_win_entered(void* data)
 		return;
 
 	struct client* c = data;
-	if (!c || c->ws != wm.ws)
+	if (!c || !client_visible(c))
 		return;
 
-	focus(c, true);
+	if (client_at(wm.sel_client) == c) {
+		wm.count.focus_noop++;
+		if (client_at(wm.focus_pending))
+			wm.count.focus_suppressed++;
+		wm.focus_pending = HANDLE_NONE;
+		return;
+	}
+
+	if (!cfg.focus_delay_ms || !wm.focus_timer) {
+		focus(c, true);
+		return;
+	}
+
+	/* commit only once the pointer settles, each enter restarts the wait */
+	if (client_at(wm.focus_pending) && !HANDLE_EQ(wm.focus_pending, c->id))
+		wm.count.focus_suppressed++;
+
+	wm.focus_pending = c->id;
+	wl_event_source_timer_update(wm.focus_timer, (int)cfg.focus_delay_ms);
+}
+
+/* only the focused title is on the status line */
+static void on_win_title_changed(void* data)
+{
+	struct client* c = data;
+
+	if (c && client_at(wm.sel_client) == c)
+		status_touch();
+}
+
+/* moves focus off c if it left the screen's view */
+static void retag(struct client* c, uint32_t tags)
+{
+	struct screen* s = screen_at(c->scr);
+	struct client* next;
+
+	if (!set_tags(c, tags))
+		return;
+
+	if (!client_visible(c)) {
+		next = top_float(s);
+		if (!next)
+			next = first_tiled(s);
+		focus(next, true);
+	}
+	tile(s);
+}
+
+/* shows c if map_client() left that to a layout pass */
+static void reveal(struct client* c)
+{
+	if (!c->show_pending)
+		return;
+
+	c->show_pending = false;
+	client_show(c);
+}
+
+static void run_bind(void* data, uint32_t time, uint32_t value, uint32_t state)
+{
+	struct bind* b = data;
+	size_t a = bind_action[b - binds];
+	uint64_t requested = wm.count.layout_requested;
+	uint64_t t0 = stats_now();
+	/* key releases are no-ops for every action, keep them out of the numbers */
+	bool counted = b->type == SWC_BINDING_BUTTON || state == WL_KEYBOARD_KEY_STATE_PRESSED;
+
+	trace_input(TRACE_BIND, (uint16_t)(b - binds), time, value, state, 0);
+	if (counted && time)
+		hist_record(&input_hist[a], stats_input_age(time, t0));
+
+	wm.in_input = true;
+	b->fn(&b->arg, time, value, state);
+	wm.in_input = false;
+
+	if (!counted)
+		return;
+
+	hist_record(&action_hist[a], stats_now() - t0);
+	if (time)
+		input_issued(a, time, wm.count.layout_requested != requested);
 }
 
 static void setup(void)
@@ -138,18 +900,47 @@ static void setup(void)
 
 	/* variables */
 	wl_list_init(&wm.screens);
-	wl_list_init(&wm.tiled);
-	wl_list_init(&wm.floating);
-	wm.sel_client = NULL;
-	wm.sel_screen = NULL;
+	for (uint32_t i = 0; i < WS_COUNT; i++) {
+		wl_list_init(&wm.limbo[i].tiled);
+		wl_list_init(&wm.limbo[i].floating);
+		wl_list_init(&wm.limbo[i].stack);
+		wm.limbo[i].layout = NULL;
+	}
+	wm.layout_idle = NULL;
+	wm.layout_timer = NULL;
+	wm.layout_waiting = false;
+	wm.layout_last = 0;
+	wm.in_input = false;
+	wm.sel_client = HANDLE_NONE;
+	wm.sel_screen = HANDLE_NONE;
 	wm.grab.active = false;
 	wm.grab.resize = false;
-	wm.grab.c = NULL;
+	wm.grab.c = HANDLE_NONE;
+	wm.focus_timer = NULL;
+	wm.focus_pending = HANDLE_NONE;
+	wm.limbo_occ = (struct occupancy){ 0 };
+	wm.geom_seq = 1;
+	wm.hold_timer = NULL;
+	wm.sigusr1 = NULL;
+	wl_list_init(&wm.held);
+
+	/* window churn after startup is served from these slabs */
+	pool_init(&wm.client_pool, sizeof(struct client), 64);
+	pool_init(&wm.screen_pool, sizeof(struct screen), 8);
 	wm.global_floating = false;
-	wm.ws = 1;
+
+	rects_cap = 64;
+	rects = malloc(rects_cap * sizeof(*rects));
+	if (!rects)
+		die(EXIT_FAILURE, "layout buffer malloc failed");
+
+	/* swc reports the screens present from within swc_initialize */
+	trace_init(cfg.trace_records);
+	rules_init(&wm.rule_index, rules, LENGTH(rules));
 
 	/* event loop */
 	wm.ev_loop = wl_display_get_event_loop(wm.dpy);
+	log_init(wm.ev_loop);
 	if (!swc_initialize(wm.dpy, wm.ev_loop, &manager))
 		die(EXIT_FAILURE, "swc_initialize failed\n");
 
@@ -161,22 +952,79 @@ static void setup(void)
 	if (!sock)
 		die(EXIT_FAILURE, "wl_display_add_socket_auto failed\n");
 	setenv("WAYLAND_DISPLAY", sock, 1);
-	_log(stderr, "WAYLAND_DISPLAY=%s\n", sock);
+	log_info("WAYLAND_DISPLAY=%s", sock);
+
+	/* control socket */
+	ipc_init(sock);
 
 	/* signals */
 	signal(SIGINT,  sig_handler);
 	signal(SIGTERM, sig_handler);
 	signal(SIGQUIT, sig_handler);
+	/* a stderr reader that went away shows up as EPIPE in the log drain */
+	signal(SIGPIPE, SIG_IGN);
+	wm.sigusr1 = wl_event_loop_add_signal(wm.ev_loop, SIGUSR1, on_sigusr1, NULL);
+	if (!wm.sigusr1)
+		log_warn("SIGUSR1 stats dump unavailable");
+
+	/* child processes */
+	launch_init();
+
+	/* pointer focus settle delay */
+	wm.focus_timer = wl_event_loop_add_timer(wm.ev_loop, on_focus_timer, NULL);
+	if (!wm.focus_timer)
+		log_warn("focus timer unavailable, focus follows the pointer at once");
+
+	/* layout passes after window churn held back by layout_settle_ms */
+	wm.layout_timer = wl_event_loop_add_timer(wm.ev_loop, on_layout_timer, NULL);
+	if (!wm.layout_timer)
+		log_warn("layout timer unavailable, layouts run at once");
+
+	/* new windows waiting for an app_id, for spawn()'s warm instances and the rules */
+	wm.hold_timer = wl_event_loop_add_timer(wm.ev_loop, on_hold_timer, NULL);
+	if (!wm.hold_timer)
+		log_warn("hold timer unavailable, windows without an app_id are shown at once");
+	warm_init(warm_pools, LENGTH(warm_pools));
 }
 
 static void setup_binds(void)
 {
+	for (size_t i = 0; i < LENGTH(actions); i++) {
+		action_hist[i].name = actions[i].name;
+		input_hist[i].name = actions[i].name;
+		issued_hist[i].name = actions[i].name;
+	}
+	action_hist[LENGTH(actions)].name = "other";
+	input_hist[LENGTH(actions)].name = "other";
+	issued_hist[LENGTH(actions)].name = "other";
+
 	for (size_t i = 0; i < LENGTH(binds); i++) {
-		const struct bind* b = &binds[i];
-		swc_add_binding(b->type, b->mods, b->ksym, b->fn, (void*)&b->arg);
+		struct bind* b = &binds[i];
+
+		bind_action[i] = LENGTH(actions);
+		for (size_t j = 0; j < LENGTH(actions); j++) {
+			if (actions[j].fn == b->fn)
+				bind_action[i] = j;
+		}
+
+		swc_add_binding(b->type, b->mods, b->ksym, run_bind, b);
 	}
 }
 
+/* hides c for a single layout while it stays on view, or shows it again */
+static void set_covered(struct client* c, bool on)
+{
+	if (c->covered == on)
+		return;
+
+	c->covered = on;
+	wm.geom_seq++;
+	if (on)
+		swc_window_hide(c->win);
+	else
+		swc_window_show(c->win);
+}
+
 static void set_floating(struct client* c, bool floating, bool raise)
 {
 	if (!c)
@@ -185,114 +1033,521 @@ static void set_floating(struct client* c, bool floating, bool raise)
 	/* client must be in exactly one list */
 	if (floating) {
 		if (!c->floating) {
+			detach(c);
 			c->floating = true;
-			wl_list_remove(&c->tiled_link);
-			wl_list_insert(&wm.floating, &c->float_link);
-		}
-		else if (raise) {
-			wl_list_remove(&c->float_link);
-			wl_list_insert(&wm.floating, &c->float_link);
+			attach(c);
 		}
 
-		swc_window_set_stacked(c->win);
+		client_set_mode(c, MODE_STACKED, false);
+		/* it left the layout that was to size or cover it */
+		set_covered(c, false);
+		reveal(c);
+		if (raise)
+			client_raise(c);
 	}
 	else {
 		if (c->floating) {
+			detach(c);
 			c->floating = false;
-			wl_list_remove(&c->float_link);
-			wl_list_insert(&wm.tiled, &c->tiled_link);
+			attach(c);
 		}
 
-		swc_window_set_tiled(c->win);
-	}
+		client_set_mode(c, MODE_TILED, false);
+	}
+}
+
+/* while shown c covers its screen, the layout there waits until it leaves */
+static void set_fullscreen(struct client* c, bool on)
+{
+	struct screen* s = screen_at(c->scr);
+	struct client* prev;
+
+	if (!s || c->fullscreen == on)
+		return;
+
+	if (on) {
+		prev = client_at(s->fs);
+		if (prev)
+			set_fullscreen(prev, false);
+
+		/* a float goes back to where it was */
+		c->w = 0;
+		if (c->floating && c->sent.geom_valid) {
+			c->x = c->sent.geom.x;
+			c->y = c->sent.geom.y;
+			c->w = c->sent.geom.width;
+			c->h = c->sent.geom.height;
+		}
+
+		c->fullscreen = true;
+		set_covered(c, false);
+		screen_view(s, s->tags, c);
+		client_set_border(c, c->sent.border_col, 0);
+		client_set_fullscreen(c, s->scr);
+	}
+	else {
+		c->fullscreen = false;
+		screen_view(s, s->tags, NULL);
+		client_set_border(c, client_at(wm.sel_client) == c ? cfg.border_col_active : cfg.border_col_normal,
+			cfg.border_width);
+		client_set_mode(c, c->floating ? MODE_STACKED : MODE_TILED, false);
+		if (c->floating && c->w)
+			client_set_geometry(c, &(struct swc_rectangle){ c->x, c->y, c->w, c->h });
+		screen_restack(s);
+	}
+
+	tile(s);
+}
+
+/* c keeps its place in the lists unless its lowest tag changes */
+static bool set_tags(struct client* c, uint32_t tags)
+{
+	struct occupancy* o;
+	bool was;
+
+	tags &= TAG_ALL;
+	if (!tags || tags == c->tags)
+		return false;
+
+	if (c->fullscreen)
+		set_fullscreen(c, false);
+	was = client_visible(c);
+
+	if (tag_first(tags) != c->ws) {
+		detach(c);
+		c->tags = tags;
+		c->ws = tag_first(tags);
+		attach(c);
+	}
+	else {
+		o = occupancy_of(screen_at(c->scr));
+		occupancy_update(o, c->tags, c->ws, -1);
+		c->tags = tags;
+		occupancy_update(o, c->tags, c->ws, 1);
+		wm.geom_seq++;
+	}
+
+	if (client_visible(c) == was)
+		return true;
+
+	if (was) {
+		client_hide(c);
+	}
+	else {
+		client_show(c);
+		if (c->floating)
+			client_set_mode(c, MODE_STACKED, true);
+	}
+
+	return true;
+}
+
+/*
+ * pointer motion is capped at the refresh rate of the client's screen
+ * while it is being moved or resized, and at motion_idle_hz otherwise
+ */
+static void set_throttle(struct client* c)
+{
+	struct screen* s = screen_at(c->scr);
+	uint32_t hz = s ? s->refresh_hz : cfg.refresh_hz;
+
+	if (!wm.grab.active || client_at(wm.grab.c) != c) {
+		if (cfg.motion_idle_hz && cfg.motion_idle_hz < hz)
+			hz = cfg.motion_idle_hz;
+	}
+
+	/* cfg.refresh_hz may be 0, a client in limbo has no screen to ask */
+	if (hz == 0)
+		hz = 1;
+
+	c->win->motion_throttle_ms = hz >= 1000 ? 1 : 1000 / hz;
+}
+
+/* swaps two entries, of the same list or not */
+static void swap_links(struct wl_list* a, struct wl_list* b)
+{
+	struct wl_list* pos;
+
+	if (a->next == b) {
+		wl_list_remove(a);
+		wl_list_insert(b, a);
+		return;
+	}
+	if (b->next == a) {
+		wl_list_remove(b);
+		wl_list_insert(a, b);
+		return;
+	}
+
+	pos = a->prev;
+	wl_list_remove(a);
+	wl_list_insert(b->prev, a);
+	wl_list_remove(b);
+	wl_list_insert(pos, b);
+}
+
+/* take back the clients that were moved off an output with the geometry of s */
+static void screen_adopt(struct screen* s)
+{
+	struct screen* from;
+
+	wl_list_for_each(from, &wm.screens, link) {
+		if (from != s && adopt_from(s, from)) {
+			tile(from);
+			tile(s);
+		}
+	}
+
+	if (adopt_from(s, NULL))
+		tile(s);
+
+	/* whatever was left without a screen has one now */
+	migrate(NULL, s);
+}
+
+/*
+ * sends a float its geometry now, false if c is tiled and gets it from
+ * the next layout pass, which shows it after (see tile_screen())
+ */
+static bool place(struct client* c, const struct rule* r)
+{
+	struct screen* s = screen_at(c->scr);
+	const struct swc_rectangle* u;
+	struct swc_rectangle g;
+
+	if (!s || !client_visible(c))
+		return true;
+
+	if (!c->floating) {
+		tile(s);
+		return false;
+	}
+
+	if (!r || !r->w || !r->h)
+		return true;
+
+	/* centred on the usable area */
+	u = &s->scr->usable_geometry;
+	g.width = r->w < u->width ? r->w : u->width;
+	g.height = r->h < u->height ? r->h : u->height;
+	g.x = u->x + (int32_t)(u->width - g.width) / 2;
+	g.y = u->y + (int32_t)(u->height - g.height) / 2;
+	client_set_geometry(c, &g);
+	return true;
+}
+
+static void screen_refresh(struct screen* s)
+{
+	const struct swc_rectangle* g = &s->scr->geometry;
+
+	s->refresh_hz = cfg.refresh_hz;
+	for (size_t i = 0; i < LENGTH(monitors); i++) {
+		if (monitors[i].width == g->width && monitors[i].height == g->height) {
+			s->refresh_hz = monitors[i].hz;
+			break;
+		}
+	}
+
+	if (s->refresh_hz == 0)
+		s->refresh_hz = 60;
+}
+
+/* screens in the order they appeared, wm.screens has the newest first */
+static struct screen* screen_nth(int32_t n)
+{
+	struct screen* s;
+
+	if (n < 0)
+		return NULL;
+
+	wl_list_for_each_reverse(s, &wm.screens, link) {
+		if (n-- == 0)
+			return s;
+	}
+
+	return NULL;
+}
+
+/* mark s (or every screen if s=NULL) for layout on the next idle pass */
+static void tile(struct screen* s)
+{
+	struct screen* screen;
+	uint64_t since;
+
+	if (s) {
+		s->dirty = true;
+	}
+	else {
+		wl_list_for_each(screen, &wm.screens, link)
+			screen->dirty = true;
+	}
+
+	wm.count.layout_requested++;
+	status_touch();
+
+	if (wm.layout_idle || (wm.layout_waiting && !wm.in_input))
+		return;
+
+	/*
+	 * a burst of window churn soon after the last pass waits and is laid
+	 * out once, what a binding or command asked for goes out on this
+	 * iteration and takes a waiting pass with it
+	 */
+	since = stats_now() - wm.layout_last;
+	if (!wm.in_input && cfg.layout_settle_ms && wm.layout_timer
+		&& since < (uint64_t)cfg.layout_settle_ms * 1000000) {
+		wl_event_source_timer_update(wm.layout_timer,
+			(int)((uint64_t)cfg.layout_settle_ms - since / 1000000));
+		wm.layout_waiting = true;
+		wm.count.layout_deferred++;
+		return;
+	}
+
+	wm.layout_idle = wl_event_loop_add_idle(wm.ev_loop, on_layout_idle, NULL);
+	if (!wm.layout_idle)
+		layout_flush();
+}
+
+static void tile_screen(struct screen* s)
+{
+	struct client* c;
+	struct client* front;
+	struct workspace* ws;
+	struct layout_params p;
+	size_t n;
+	size_t i = 0;
+
+	wm.count.layout_run++;
+
+	/* the clients it covers are hidden, nothing to lay out */
+	c = client_at(s->fs);
+	if (c && client_visible(c)) {
+		client_set_fullscreen(c, s->scr);
+		return;
+	}
+
+	ws = workspace_cur(s);
+	if (!ws)
+		return;
+
+	/* every shown tag is laid out together, by the lowest one's layout */
+	n = 0;
+	for (c = first_tiled(s); c; c = next_tiled(s, c))
+		n++;
+	if (n == 0)
+		return;
+
+	if (n > rects_cap) {
+		size_t cap = rects_cap * 2 > n ? rects_cap * 2 : n;
+		struct swc_rectangle* r = realloc(rects, cap * sizeof(*r));
+
+		if (!r) {
+			log_warn("layout of %zu windows failed, out of memory", n);
+			return;
+		}
+		rects = r;
+		rects_cap = cap;
+	}
+
+	p.area = s->scr->usable_geometry;
+	p.gaps = cfg.gaps;
+	p.border_width = cfg.border_width;
+
+	if (master_width == 0) { /* uninitialised */
+		uint32_t out_gaps = cfg.gaps + cfg.border_width;
+		uint32_t in_gaps = cfg.gaps + (cfg.border_width * 2);
+
+		master_width = ((p.area.width - (out_gaps * 2) - in_gaps) * cfg.master_width) / 100;
+	}
+	p.master_width = master_width;
+
+	ws->layout->fn(&p, n, rects);
+
+	/* a single layout shows the focused tiled client, or the one it showed last */
+	front = NULL;
+	if (ws->layout->single) {
+		front = client_at(wm.sel_client);
+		if (!tiled_on(front, s))
+			front = front_of(s);
+		if (!front)
+			front = first_tiled(s);
+		s->front = front->id;
+	}
+
+	for (c = first_tiled(s); c; c = next_tiled(s, c)) {
+		if (front && c != front) {
+			set_covered(c, true);
+		}
+		else if (c->covered) {
+			/* shown like a new window, once it has its size */
+			c->covered = false;
+			c->show_pending = true;
+			wm.geom_seq++;
+		}
+		/* a new window goes up only once it has been sent its size */
+		client_set_geometry(c, &rects[i++]);
+		reveal(c);
+	}
+}
+
+/* c is a tiled client shown on s */
+static bool tiled_on(const struct client* c, const struct screen* s)
+{
+	return c && HANDLE_EQ(c->scr, s->id) && !wl_list_empty(&c->tiled_link) && client_visible(c);
+}
+
+static void timed_new_screen(struct swc_screen* scr)
+{
+	trace_screen(TRACE_NEW_SCREEN, scr, &scr->geometry, 0);
+	trace_screen(TRACE_SCREEN_USABLE, scr, &scr->usable_geometry, TRACE_USABLE_INITIAL);
+	TIMED(&stats[STAT_NEW_SCREEN], new_screen(scr));
+}
+
+static void timed_new_window(struct swc_window* win)
+{
+	TIMED(&stats[STAT_NEW_WINDOW], new_window(win));
+}
+
+static void timed_screen_geometry(void* data)
+{
+	struct screen* s = data;
+
+	if (s)
+		trace_screen(TRACE_SCREEN_USABLE, s->scr, &s->scr->usable_geometry, 0);
+	TIMED(&stats[STAT_SCREEN_GEOMETRY], on_screen_usable_geometry_changed(data));
+}
+
+static void timed_win_destroy(void* data)
+{
+	struct client* c = data;
+
+	if (c)
+		trace_window(TRACE_WIN_DESTROY, c->win, 0);
+	TIMED(&stats[STAT_WIN_DESTROY], on_win_destroy(data));
+}
+
+static void timed_win_entered(void* data)
+{
+	struct client* c = data;
+
+	if (c)
+		trace_window(TRACE_WIN_ENTERED, c->win, 0);
+	TIMED(&stats[STAT_WIN_ENTERED], on_win_entered(data));
+}
+
+/* other screens keep their tags, only clients on s are touched */
+static void view_tags(struct screen* s, uint32_t tags)
+{
+	struct client* c;
+
+	tags &= TAG_ALL;
+	if (!s || !tags || tags == s->tags)
+		return;
+
+	screen_view(s, tags, client_at(s->fs));
+	screen_restack(s);
+
+	c = top_float(s);
+	if (!c)
+		c = first_tiled(s);
+	focus(c, true);
+	tile(s);
 }
 
-static void tile(struct screen* s)
+void cycle_layout(void* data, uint32_t time, uint32_t value, uint32_t state)
 {
-	struct client* c;
-	struct screen* screen;
-	struct swc_rectangle geom;
-	struct swc_rectangle* scr_geom;
+	(void)data;
+	(void)time;
+	(void)value;
 
-	int32_t out_gaps = cfg.gaps + cfg.border_width;
-	int32_t in_gaps = cfg.gaps + (cfg.border_width * 2);
+	struct screen* s;
+	struct workspace* w;
+	size_t i;
 
-	int32_t x;
-	int32_t y;
-	uint32_t w;
-	uint32_t h;
+	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
+		return;
 
-	/* if s=NULL, tile all screens */
-	if (!s) {
-		wl_list_for_each(screen, &wm.screens, link)
-			tile(screen);
+	s = screen_at(wm.sel_screen);
+	w = workspace_cur(s);
+	if (!w)
 		return;
-	}
 
-	scr_geom = &s->scr->usable_geometry;
+	i = (size_t)(w->layout - layouts);
+	w->layout = &layouts[(i + 1) % LENGTH(layouts)];
+	tile(s);
+}
 
-	size_t n = 0;
-	wl_list_for_each(c, &wm.tiled, tiled_link) {
-		if (is_tiled(c, s))
-			n++;
-	}
-	if (n == 0)
-		return;
+void dump_latency(FILE* fd)
+{
+	hist_header(fd, "input to handler");
+	for (size_t i = 0; i < LENGTH(input_hist); i++)
+		hist_dump(&input_hist[i], fd);
 
-	/* calculate tiling area */
-	x = scr_geom->x + out_gaps;
-	y = scr_geom->y + out_gaps;
-	w = scr_geom->width - (out_gaps * 2);
-	h = scr_geom->height - (out_gaps * 2);
+	hist_header(fd, "input to focus/layout out");
+	for (size_t i = 0; i < LENGTH(issued_hist); i++)
+		hist_dump(&issued_hist[i], fd);
+}
 
-	/* one window, fullscreen it */
-	if (n == 1) {
-		wl_list_for_each(c, &wm.tiled, tiled_link) {
-			if (!is_tiled(c, s))
-				continue;
+void dump_stats(FILE* fd)
+{
+	stats_dump(fd);
+	for (size_t i = 0; i < LENGTH(action_hist); i++)
+		hist_dump(&action_hist[i], fd);
+	dump_latency(fd);
+	log_counters(fd);
+}
 
-			geom.x = x;
-			geom.y = y;
-			geom.width  = w;
-			geom.height = h;
+int dump_trace(const char* path)
+{
+	return trace_dump(path, LENGTH(binds), LENGTH(actions), LENGTH(rules));
+}
 
-			swc_window_set_geometry(c->win, &geom);
-			return;
-		}
+const struct action* find_action(const char* name)
+{
+	for (size_t i = 0; i < LENGTH(actions); i++) {
+		if (strcmp(actions[i].name, name) == 0)
+			return &actions[i];
 	}
 
-	/* tile */
-	size_t i = 0;
-	wl_list_for_each(c, &wm.tiled, tiled_link) {
-		if (!is_tiled(c, s))
-			continue;
+	return NULL;
+}
 
-		if (master_width == 0) /* uninitialised */
-			master_width = ((w - in_gaps) * cfg.master_width) / 100;
+const struct layout* find_layout(const char* name)
+{
+	for (size_t i = 0; i < LENGTH(layouts); i++) {
+		if (strcmp(layouts[i].name, name) == 0)
+			return &layouts[i];
+	}
 
-		if (i == 0) {
-			/* master */
-			geom.x = x;
-			geom.y = y;
-			geom.width = master_width;
-			geom.height = h;
-		}
-		else {
-			/* stack */
-			uint32_t stackn = n - 1;
-			uint32_t idx = i - 1;
+	return NULL;
+}
 
-			uint32_t stack_height = (h - in_gaps * (stackn - 1)) / stackn;
+void focus_dir(void* data, uint32_t time, uint32_t value, uint32_t state)
+{
+	(void)time;
+	(void)value;
 
-			geom.x = x + master_width + in_gaps;
-			geom.y = y + (idx * (stack_height + in_gaps));
-			geom.width  = w - master_width - in_gaps;
-			geom.height = stack_height;
-		}
+	const union arg* a = data;
+	struct client* c;
+	struct client* sel;
+	struct screen* s;
+	struct swc_rectangle from;
 
-		swc_window_set_geometry(c->win, &geom);
-		i++;
-	}
+	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
+		return;
+
+	s = screen_at(wm.sel_screen);
+	if (!s || a->u > DIR_DOWN)
+		return;
+
+	sel = client_at(wm.sel_client);
+	if (sel && sel->fullscreen)
+		return;
+
+	dir_origin(sel, s, a->u, &from);
+	c = spatial_neighbour(s, sel, &from, a->u);
+	if (c)
+		focus(c, true);
 }
 
 void focus_next(void* data, uint32_t time, uint32_t value, uint32_t state)
@@ -302,17 +1557,19 @@ void focus_next(void* data, uint32_t time, uint32_t value, uint32_t state)
 	(void)value;
 
 	struct client* c;
+	struct client* sel;
 	struct screen* s;
 
 	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
 		return;
 
-	if (!wm.sel_screen)
+	s = screen_at(wm.sel_screen);
+	if (!s)
 		return;
 
-	s = wm.sel_screen;
+	sel = client_at(wm.sel_client);
 
-	if (!wm.sel_client) {
+	if (!sel) {
 		c = first_float(s);
 		if (!c)
 			c = first_tiled(s);
@@ -321,14 +1578,11 @@ void focus_next(void* data, uint32_t time, uint32_t value, uint32_t state)
 	}
 
 	/* do not raise/reorder floats while cycling */
-	if (wm.sel_client->floating) {
-		for (c = wl_container_of(wm.sel_client->float_link.next, c, float_link);
-			&c->float_link != &wm.floating;
-			c = wl_container_of(c->float_link.next, c, float_link)) {
-			if (is_float(c, s)) {
-				focus(c, false);
-				return;
-			}
+	if (sel->floating) {
+		c = is_float(sel, s) ? next_float(s, sel) : NULL;
+		if (c) {
+			focus(c, false);
+			return;
 		}
 
 		c = first_tiled(s);
@@ -339,13 +1593,10 @@ void focus_next(void* data, uint32_t time, uint32_t value, uint32_t state)
 		return;
 	}
 
-	for (c = wl_container_of(wm.sel_client->tiled_link.next, c, tiled_link);
-		&c->tiled_link != &wm.tiled;
-		c = wl_container_of(c->tiled_link.next, c, tiled_link)) {
-		if (is_tiled(c, s)) {
-			focus(c, false);
-			return;
-		}
+	c = is_tiled(sel, s) ? next_tiled(s, sel) : NULL;
+	if (c) {
+		focus(c, false);
+		return;
 	}
 
 	c = first_float(s);
@@ -361,17 +1612,19 @@ void focus_prev(void* data, uint32_t time, uint32_t value, uint32_t state)
 	(void)value;
 
 	struct client* c;
+	struct client* sel;
 	struct screen* s;
 
 	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
 		return;
 
-	if (!wm.sel_screen)
+	s = screen_at(wm.sel_screen);
+	if (!s)
 		return;
 
-	s = wm.sel_screen;
+	sel = client_at(wm.sel_client);
 
-	if (!wm.sel_client) {
+	if (!sel) {
 		c = first_float(s);
 		if (!c)
 			c = first_tiled(s);
@@ -379,14 +1632,11 @@ void focus_prev(void* data, uint32_t time, uint32_t value, uint32_t state)
 		return;
 	}
 
-	if (wm.sel_client->floating) {
-		for (c = wl_container_of(wm.sel_client->float_link.prev, c, float_link);
-			&c->float_link != &wm.floating;
-			c = wl_container_of(c->float_link.prev, c, float_link)) {
-			if (is_float(c, s)) {
-				focus(c, false);
-				return;
-			}
+	if (sel->floating) {
+		c = is_float(sel, s) ? prev_float(s, sel) : NULL;
+		if (c) {
+			focus(c, false);
+			return;
 		}
 
 		c = last_tiled(s);
@@ -397,13 +1647,10 @@ void focus_prev(void* data, uint32_t time, uint32_t value, uint32_t state)
 		return;
 	}
 
-	for (c = wl_container_of(wm.sel_client->tiled_link.prev, c, tiled_link);
-		&c->tiled_link != &wm.tiled;
-		c = wl_container_of(c->tiled_link.prev, c, tiled_link)) {
-		if (is_tiled(c, s)) {
-			focus(c, false);
-			return;
-		}
+	c = is_tiled(sel, s) ? prev_tiled(s, sel) : NULL;
+	if (c) {
+		focus(c, false);
+		return;
 	}
 
 	c = last_float(s);
@@ -425,14 +1672,15 @@ void master_next(void* data, uint32_t time, uint32_t value, uint32_t state)
 	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
 		return;
 
-	if (!wm.sel_screen)
+	s = screen_at(wm.sel_screen);
+	if (!s)
 		return;
 
-	s = wm.sel_screen;
 	first = first_tiled(s);
 	last = last_tiled(s);
 
-	if (!first || !last || first == last)
+	/* order is kept per workspace, a view over several is not rotated */
+	if (!first || !last || first == last || first->ws != last->ws)
 		return;
 
 	wl_list_remove(&last->tiled_link);
@@ -453,14 +1701,15 @@ void master_prev(void* data, uint32_t time, uint32_t value, uint32_t state)
 	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
 		return;
 
-	if (!wm.sel_screen)
+	s = screen_at(wm.sel_screen);
+	if (!s)
 		return;
 
-	s = wm.sel_screen;
 	first = first_tiled(s);
 	last = last_tiled(s);
 
-	if (!first || !last || first == last)
+	/* order is kept per workspace, a view over several is not rotated */
+	if (!first || !last || first == last || first->ws != last->ws)
 		return;
 
 	wl_list_remove(&first->tiled_link);
@@ -474,13 +1723,16 @@ void kill_sel(void* data, uint32_t time, uint32_t value, uint32_t state)
 	(void)time;
 	(void)value;
 
+	struct client* c;
+
 	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
 		return;
 
-	if (!wm.sel_client)
+	c = client_at(wm.sel_client);
+	if (!c)
 		return;
 
-	swc_window_close(wm.sel_client->win);
+	swc_window_close(c->win);
 }
 
 void master_resize(void* data, uint32_t time, uint32_t value, uint32_t state)
@@ -489,15 +1741,17 @@ void master_resize(void* data, uint32_t time, uint32_t value, uint32_t state)
 	(void)value;
 
 	union arg* a = data;
+	struct screen* s;
 
 	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
 		return;
 
-	if (!wm.sel_screen)
+	s = screen_at(wm.sel_screen);
+	if (!s)
 		return;
 
 	{ /* bounds */
-		struct swc_rectangle* g = &wm.sel_screen->scr->usable_geometry;
+		struct swc_rectangle* g = &s->scr->usable_geometry;
 
 		uint32_t out_gaps = cfg.gaps + cfg.border_width;
 		uint32_t in_gaps = cfg.gaps + (cfg.border_width * 2);
@@ -520,7 +1774,7 @@ void master_resize(void* data, uint32_t time, uint32_t value, uint32_t state)
 		master_width = (uint32_t)mw;
 	}
 
-	tile(wm.sel_screen);
+	tile(s);
 }
 
 void mouse_move(void* data, uint32_t time, uint32_t value, uint32_t state)
@@ -529,29 +1783,41 @@ void mouse_move(void* data, uint32_t time, uint32_t value, uint32_t state)
 	(void)time;
 	(void)value;
 
+	struct client* c;
+
 	if (state == WL_POINTER_BUTTON_STATE_PRESSED) {
-		if (!wm.sel_client)
+		c = client_at(wm.sel_client);
+		if (!c || c->fullscreen)
 			return;
 
-		if (!wm.sel_client->floating) {
-			set_floating(wm.sel_client, true, false);
-			tile(wm.sel_client->scr);
+		if (!c->floating) {
+			set_floating(c, true, false);
+			tile(screen_at(c->scr));
 		}
 
 		wm.grab.active = true;
 		wm.grab.resize = false;
-		wm.grab.c = wm.sel_client;
+		wm.grab.c = c->id;
 
-		swc_window_begin_move(wm.grab.c->win);
+		/* geometry is now driven by the pointer */
+		c->sent.geom_valid = false;
+		wm.geom_seq++;
+		set_throttle(c);
+		swc_window_begin_move(c->win);
 	}
 	else {
-		if (!wm.grab.active || wm.grab.resize || !wm.grab.c)
+		c = client_at(wm.grab.c);
+		if (!wm.grab.active || wm.grab.resize || !c)
 			return;
 
-		swc_window_end_move(wm.grab.c->win);
+		swc_window_end_move(c->win);
 
+		/* where the pointer left it is not known here */
+		c->sent.geom_valid = false;
+		wm.geom_seq++;
 		wm.grab.active = false;
-		wm.grab.c = NULL;
+		wm.grab.c = HANDLE_NONE;
+		set_throttle(c);
 	}
 }
 
@@ -561,98 +1827,182 @@ void mouse_resize(void* data, uint32_t time, uint32_t value, uint32_t state)
 	(void)time;
 	(void)value;
 
+	struct client* c;
+
 	if (state == WL_POINTER_BUTTON_STATE_PRESSED) {
-		if (!wm.sel_client)
+		c = client_at(wm.sel_client);
+		if (!c || c->fullscreen)
 			return;
 
-		if (!wm.sel_client->floating) {
-			set_floating(wm.sel_client, true, false);
-			tile(wm.sel_client->scr);
+		if (!c->floating) {
+			set_floating(c, true, false);
+			tile(screen_at(c->scr));
 		}
 
 		wm.grab.active = true;
 		wm.grab.resize = true;
-		wm.grab.c = wm.sel_client;
+		wm.grab.c = c->id;
 
+		c->sent.geom_valid = false;
+		wm.geom_seq++;
+		set_throttle(c);
 		swc_window_begin_resize(
-			wm.grab.c->win,
+			c->win,
 			SWC_WINDOW_EDGE_RIGHT | SWC_WINDOW_EDGE_BOTTOM
 		);
 	}
 	else {
-		if (!wm.grab.active || !wm.grab.resize || !wm.grab.c)
+		c = client_at(wm.grab.c);
+		if (!wm.grab.active || !wm.grab.resize || !c)
 			return;
 
-		swc_window_end_resize(wm.grab.c->win);
+		swc_window_end_resize(c->win);
 
+		/* where the pointer left it is not known here */
+		c->sent.geom_valid = false;
+		wm.geom_seq++;
 		wm.grab.active = false;
-		wm.grab.c = NULL;
+		wm.grab.c = HANDLE_NONE;
+		set_throttle(c);
+	}
+}
+
+/* slides the focused float until an edge of it meets a window or usable area edge */
+void move_dir(void* data, uint32_t time, uint32_t value, uint32_t state)
+{
+	(void)time;
+	(void)value;
+
+	const union arg* a = data;
+	struct client* c;
+	struct screen* s;
+	struct swc_rectangle g;
+	int32_t edge;
+	/* a border or gap away is the same edge */
+	int32_t slack = (int32_t)(2 * cfg.border_width + cfg.gaps);
+
+	if (state != WL_KEYBOARD_KEY_STATE_PRESSED || a->u > DIR_DOWN)
+		return;
+
+	c = client_at(wm.sel_client);
+	s = c ? screen_at(c->scr) : NULL;
+	if (!s || !c->floating || c->fullscreen || !c->sent.geom_valid || wm.grab.active)
+		return;
+
+	g = c->sent.geom;
+	switch (a->u) {
+	case DIR_LEFT:
+		if (spatial_snap(s, g.x, slack, DIR_LEFT, &edge))
+			g.x = edge;
+		break;
+	case DIR_RIGHT:
+		if (spatial_snap(s, g.x + (int32_t)g.width, slack, DIR_RIGHT, &edge))
+			g.x = edge - (int32_t)g.width;
+		break;
+	case DIR_UP:
+		if (spatial_snap(s, g.y, slack, DIR_UP, &edge))
+			g.y = edge;
+		break;
+	case DIR_DOWN:
+		if (spatial_snap(s, g.y + (int32_t)g.height, slack, DIR_DOWN, &edge))
+			g.y = edge - (int32_t)g.height;
+		break;
 	}
+
+	client_set_geometry(c, &g);
 }
 
 void new_screen(struct swc_screen* scr)
 {
+	struct handle h;
 	struct screen* s;
 
-	s = malloc(sizeof(*s));
+	s = pool_alloc(&wm.screen_pool, &h);
 	if (!s)
-		die(EXIT_FAILURE, "new screen calloc failed");
+		die(EXIT_FAILURE, "new screen alloc failed");
 
+	s->id = h;
 	s->scr = scr;
+	screen_refresh(s);
+
+	for (uint32_t i = 0; i < WS_COUNT; i++) {
+		wl_list_init(&s->ws[i].tiled);
+		wl_list_init(&s->ws[i].floating);
+		wl_list_init(&s->ws[i].stack);
+		s->ws[i].layout = ws_layouts[i] ? ws_layouts[i] : &layouts[0];
+	}
+	s->occ = (struct occupancy){ 0 };
+	s->tags = TAG(1);
+	s->sel_ws = 1;
+	s->fs = HANDLE_NONE;
+	s->front = HANDLE_NONE;
 
 	s->x = 0;
 	s->y = 0;
 	s->w = 0;
 	s->h = 0;
+	s->index = (struct spatial){ 0 };
 
 	wl_list_insert(&wm.screens, &s->link);
 
-	if (!wm.sel_screen)
-		wm.sel_screen = s;
+	if (!screen_at(wm.sel_screen))
+		wm.sel_screen = s->id;
 
 	swc_screen_set_handler(scr, &screen_handler, s);
+	screen_adopt(s);
 
-	_log(stderr, "new_screen=%p\n", (void*)scr);
+	log_debug("new_screen=%p", (void*)scr);
 }
 
 void new_window(struct swc_window* win)
 {
 	struct client* c;
+	struct handle h;
+	const struct rule* r;
 
-	c = malloc(sizeof(*c));
+	c = pool_alloc(&wm.client_pool, &h);
 	if (!c)
-		die(EXIT_FAILURE, "malloc client failed");
+		die(EXIT_FAILURE, "client alloc failed");
 
-	win->motion_throttle_ms = 1000 / cfg.motion_throttle_hz;
 	win->min_width = 20;
 	win->min_height = 20;
 	win->max_width = 0;
 	win->max_height = 0;
 
+	c->id = h;
 	c->win = win;
 	c->scr = wm.sel_screen;
 	c->mapped = false;
+	c->show_pending = false;
+	c->covered = false;
+	c->over = HANDLE_NONE;
+	c->warm = 0;
+	c->held_until = 0;
 	c->floating = wm.global_floating;
 	c->fullscreen = false;
-	c->ws = wm.ws;
-
-	if (c->floating) {
-		wl_list_insert(&wm.floating, &c->float_link);
-		wl_list_init(&c->tiled_link);
-		swc_window_set_handler(win, &window_handler, c);
-		swc_window_set_stacked(win);
-	}
-	else {
-		wl_list_insert(&wm.tiled, &c->tiled_link);
-		wl_list_init(&c->float_link);
-		swc_window_set_handler(win, &window_handler, c);
-		swc_window_set_tiled(win);
+	c->ws = 0;
+	c->tags = 0;
+	c->sent = (struct shadow){ .mode = MODE_UNSET };
+	c->home = (struct swc_rectangle){ 0 };
+	wl_list_init(&c->tiled_link);
+	wl_list_init(&c->float_link);
+	wl_list_init(&c->stack_link);
+
+	r = rules_match(&wm.rule_index, win->app_id, win->title);
+	trace_window(TRACE_NEW_WINDOW, win, r ? (uint16_t)(r - rules + 1) : 0);
+	c->ruled = win->app_id != NULL;
+	swc_window_set_handler(win, &window_handler, c);
+
+	/* a warm instance, or one whose app_id may still pick an earlier rule */
+	if (!warm_park(c)) {
+		if (!win->app_id && wm.hold_timer
+			&& (warm_pending() || (cfg.rule_hold_ms && rules_await_app_id(&wm.rule_index, r))))
+			hold(c);
+		else
+			map_client(c, r);
 	}
-	swc_window_show(win);
-	focus(c, true);
-	tile(wm.sel_screen);
 
-	_log(stderr, "new_window=%p\n", (void*)win);
+	log_debug("new_window=%p", (void*)win);
 }
 
 void new_device(struct libinput_device* dev)
@@ -670,21 +2020,123 @@ void quit(void* data, uint32_t time, uint32_t value, uint32_t state)
 	wl_display_terminate(wm.dpy);
 }
 
+/* entry point for actions not bound to a key, recorded like a bind */
+void run_action(const struct action* a, union arg* arg, uint32_t time)
+{
+	int32_t v = 0;
+
+	if (a->arg == ARG_INT || a->arg == ARG_UINT || a->arg == ARG_DIR)
+		v = arg->i;
+	else if (a->arg == ARG_LAYOUT)
+		v = (int32_t)((const struct layout*)arg->v - layouts);
+
+	trace_input(TRACE_ACTION, (uint16_t)(a - actions), time, 0, WL_KEYBOARD_KEY_STATE_PRESSED, v);
+	wm.in_input = true;
+	a->fn(arg, time, 0, WL_KEYBOARD_KEY_STATE_PRESSED);
+	wm.in_input = false;
+}
+
+void set_layout(void* data, uint32_t time, uint32_t value, uint32_t state)
+{
+	(void)time;
+	(void)value;
+
+	union arg* a = data;
+	struct screen* s;
+	struct workspace* w;
+
+	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
+		return;
+
+	s = screen_at(wm.sel_screen);
+	w = workspace_cur(s);
+	if (!w || !a->v || w->layout == a->v)
+		return;
+
+	w->layout = a->v;
+	tile(s);
+}
+
 void spawn(void* data, uint32_t time, uint32_t value, uint32_t state)
 {
 	union arg* a = data;
 	char* const* cmd = (char* const*)a->v;
+	struct client* c;
 
-	(void)time;
 	(void)value;
 
 	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
 		return;
 
-	if (fork() == 0) {
-		execvp(cmd[0], cmd);
-		_exit(127);
+	/* rules are for new windows, an instance goes where spawn() was asked */
+	c = warm_take(cmd);
+	if (c) {
+		map_client(c, NULL);
+		return;
+	}
+
+	launch_spawn(cmd, time);
+}
+
+/*
+ * swaps the focused client with its neighbour in dir: tiled ones trade
+ * places in the layout, floating ones their geometry
+ */
+void swap_dir(void* data, uint32_t time, uint32_t value, uint32_t state)
+{
+	(void)time;
+	(void)value;
+
+	const union arg* a = data;
+	struct client* c;
+	struct client* n;
+	struct screen* s;
+	struct swc_rectangle g;
+
+	if (state != WL_KEYBOARD_KEY_STATE_PRESSED || a->u > DIR_DOWN)
+		return;
+
+	c = client_at(wm.sel_client);
+	s = c ? screen_at(c->scr) : NULL;
+	if (!s || c->fullscreen || !c->sent.geom_valid || !client_visible(c) || wm.grab.active)
+		return;
+
+	n = spatial_neighbour(s, c, &c->sent.geom, a->u);
+	if (!n || n->floating != c->floating)
+		return;
+
+	if (c->floating) {
+		g = c->sent.geom;
+		client_set_geometry(c, &n->sent.geom);
+		client_set_geometry(n, &g);
+		return;
 	}
+
+	/* order is kept per workspace, as with master_next */
+	if (c->ws != n->ws)
+		return;
+
+	swap_links(&c->tiled_link, &n->tiled_link);
+	tile(s);
+}
+
+/* a->u is a tag mask, TAG_ALL makes the client sticky */
+void tag(void* data, uint32_t time, uint32_t value, uint32_t state)
+{
+	(void)time;
+	(void)value;
+
+	union arg* a = data;
+	struct client* c;
+
+	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
+		return;
+
+	c = client_at(wm.sel_client);
+	if (!c)
+		return;
+
+	retag(c, a->u);
 }
 
 void toggle_float(void* data, uint32_t time, uint32_t value, uint32_t state)
@@ -693,15 +2145,18 @@ void toggle_float(void* data, uint32_t time, uint32_t value, uint32_t state)
 	(void)time;
 	(void)value;
 
+	struct client* c;
+
 	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
 		return;
 
-	if (!wm.sel_client)
+	c = client_at(wm.sel_client);
+	if (!c || c->fullscreen)
 		return;
 
-	set_floating(wm.sel_client, !wm.sel_client->floating, true);
+	set_floating(c, !c->floating, true);
 
-	tile(wm.sel_client->scr);
+	tile(screen_at(c->scr));
 }
 
 void toggle_float_global(void* data, uint32_t time, uint32_t value, uint32_t state)
@@ -716,79 +2171,154 @@ void toggle_float_global(void* data, uint32_t time, uint32_t value, uint32_t sta
 	wm.global_floating = !wm.global_floating;
 }
 
-void workspace_goto(void* data, uint32_t time, uint32_t value, uint32_t state)
+/* fullscreen is a state of the focused client, not a layout */
+void toggle_fullscreen(void* data, uint32_t time, uint32_t value, uint32_t state)
 {
+	(void)data;
 	(void)time;
 	(void)value;
 
-	union arg* a = data;
 	struct client* c;
-	struct screen* s;
 
 	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
 		return;
 
-	if (a->u == wm.ws)
+	c = client_at(wm.sel_client);
+	if (!c)
 		return;
 
-	wm.ws = a->u;
-	sync_window_visibility();
+	set_fullscreen(c, !c->fullscreen);
+}
 
-	if (!wm.sel_screen)
-		return;
+/* the last tag of a client or a view cannot be toggled off */
+void toggle_tag(void* data, uint32_t time, uint32_t value, uint32_t state)
+{
+	(void)time;
+	(void)value;
 
-	s = wm.sel_screen;
+	union arg* a = data;
+	struct client* c;
 
-	c = first_float(s);
+	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
+		return;
+
+	c = client_at(wm.sel_client);
 	if (!c)
-		c = first_tiled(s);
-	focus(c, true);
-	tile(NULL);
+		return;
+
+	retag(c, c->tags ^ a->u);
 }
 
-void workspace_moveto(void* data, uint32_t time, uint32_t value, uint32_t state)
+void toggle_view(void* data, uint32_t time, uint32_t value, uint32_t state)
 {
 	(void)time;
 	(void)value;
 
 	union arg* a = data;
-	struct client* c;
-	struct client* next;
+	struct screen* s;
 
 	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
 		return;
 
-	if (!wm.sel_client)
+	s = screen_at(wm.sel_screen);
+	if (!s)
 		return;
 
-	c = wm.sel_client;
+	view_tags(s, s->tags ^ a->u);
+}
+
+void view(void* data, uint32_t time, uint32_t value, uint32_t state)
+{
+	(void)time;
+	(void)value;
+
+	union arg* a = data;
 
-	if (c->ws == a->u)
+	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
 		return;
 
-	c->ws = a->u;
-	if (c->ws == wm.ws)
-		swc_window_show(c->win);
-	else
-		swc_window_hide(c->win);
+	view_tags(screen_at(wm.sel_screen), a->u);
+}
 
-	next = NULL;
-	if (wm.sel_screen) {
-		next = first_float(wm.sel_screen);
-		if (!next)
-			next = first_tiled(wm.sel_screen);
+/* the next occupied workspace in the direction of a->i, from the occupancy mask */
+void workspace_cycle(void* data, uint32_t time, uint32_t value, uint32_t state)
+{
+	(void)time;
+	(void)value;
+
+	union arg* a = data;
+	struct screen* s;
+	uint32_t ws;
+
+	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
+		return;
+
+	s = screen_at(wm.sel_screen);
+	if (!s)
+		return;
+
+	ws = s->sel_ws;
+	for (uint32_t i = 1; i < WS_COUNT; i++) {
+		ws = a->i < 0 ? (ws + WS_COUNT - 2) % WS_COUNT + 1 : ws % WS_COUNT + 1;
+		if (s->occ.mask & TAG(ws)) {
+			view_tags(s, TAG(ws));
+			return;
+		}
 	}
+}
+
+void workspace_goto(void* data, uint32_t time, uint32_t value, uint32_t state)
+{
+	(void)time;
+	(void)value;
+
+	union arg* a = data;
+
+	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
+		return;
+
+	if (a->u < 1 || a->u > WS_COUNT)
+		return;
+
+	view_tags(screen_at(wm.sel_screen), TAG(a->u));
+}
+
+void workspace_moveto(void* data, uint32_t time, uint32_t value, uint32_t state)
+{
+	(void)time;
+	(void)value;
+
+	union arg* a = data;
+	struct client* c;
+
+	if (state != WL_KEYBOARD_KEY_STATE_PRESSED)
+		return;
+
+	c = client_at(wm.sel_client);
+	if (!c || a->u < 1 || a->u > WS_COUNT)
+		return;
 
-	focus(next, true);
-	tile(NULL);
+	retag(c, TAG(a->u));
 }
 
 int main(void)
 {
 	setup();
 	wl_display_run(wm.dpy);
+	log_flush();
+	log_counters(stderr);
+	ipc_finish();
+	status_finish();
+	trace_finish();
+	warm_finish();
+	launch_finish();
 	swc_finalize();
+	cleanup();
+	log_finish();
 	wl_display_destroy(wm.dpy);
+	pool_finish(&wm.client_pool);
+	pool_finish(&wm.screen_pool);
+	rules_finish(&wm.rule_index);
 	return EXIT_SUCCESS;
 }
 